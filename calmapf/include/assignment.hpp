@@ -0,0 +1,15 @@
+// Minimum cost assignment definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+
+/**
+ * @brief Solve minimum cost assignment with the Hungarian algorithm in
+ *        O(n^2 m) for n rows and m columns.
+ * @param cost cost matrix, cost[i][j] is the cost of assigning row i to
+ *        column j, rows must not outnumber columns.
+ * @return column assigned to each row, every column is used at most once.
+*/
+std::vector<int> solve_min_cost_assignment(const std::vector<std::vector<int>>& cost);
@@ -5,9 +5,19 @@
 
 #include "utils.hpp"
 #include "parser.hpp"
+#include "frequency_sketch.hpp"
+#include "shadow_cache.hpp"
 #include <cassert>
 
+// Policies compared by adaptive cache, RANDOM is excluded since it
+// consumes the shared random generator
+static const std::vector<CacheType> ADAPTIVE_CACHE_TYPES = {
+    CacheType::LRU, CacheType::FIFO, CacheType::LFU, CacheType::ARC, CacheType::TINYLFU };
+
 struct Cache {
+    // Live evicted policy, only changes with adaptive cache
+    CacheType cache_type;
+
     std::vector<Vertices> node_cargo;
     std::vector<Vertices> node_id;
     std::vector<Vertices> node_coming_cargo;
@@ -15,6 +25,9 @@ struct Cache {
     std::vector<std::vector<uint>> bit_cache_get_lock;
     std::vector<std::vector<uint>> bit_cache_insert_or_clear_lock;
     std::vector<std::vector<bool>> is_empty;
+    uint block_num = 0;                         // cache blocks of all groups
+    // Role and slot of each vertex, owned by graph
+    const std::vector<VertexInfo>* vertex_info = nullptr;
 
     // LRU paras
     std::vector<std::vector<int>> LRU;
@@ -26,6 +39,48 @@ struct Cache {
 
     // Random paras (no paras)
 
+    // LFU paras
+    std::vector<std::vector<uint>> LFU;
+    std::vector<uint> LFU_cnt;                  // accesses since last aging
+
+    // ARC paras
+    std::vector<std::vector<int>> ARC;          // recency stamp
+    std::vector<uint> ARC_cnt;
+    std::vector<std::vector<bool>> ARC_T2;      // block is in frequent list T2
+    std::vector<double> ARC_p;                  // target size of recent list T1
+    std::vector<std::deque<Vertex*>> ARC_B1;    // ghost list of T1
+    std::vector<std::deque<Vertex*>> ARC_B2;    // ghost list of T2
+
+    // TinyLFU paras (eviction reuses LRU paras)
+    std::vector<FrequencySketch> sketch;
+
+    // Distance-aware paras, distance from each cache block to all vertices
+    std::vector<std::vector<std::vector<int>>> node_dist;
+
+    // Adaptive paras, shadow caches index: group & ADAPTIVE_CACHE_TYPES
+    std::vector<std::vector<ShadowCache>> shadow;
+    uint adaptive_cnt = 0;                      // requests in current epoch
+    uint adaptive_epoch_cnt = 0;
+    uint adaptive_lead = 0;                     // consecutive epochs the leader wins
+    CacheType adaptive_leader = CacheType::NONE;
+    uint adaptive_switch_cnt = 0;
+
+    // Shared cache paras, index: cargo group
+    std::vector<uint> shared_quota;             // blocks a group may occupy in all groups
+    std::vector<uint> shared_request;           // requests in current epoch
+    std::vector<uint> shared_hit;               // cache hits in current epoch
+    uint shared_request_cnt = 0;
+    uint shared_borrow_cnt = 0;                 // insertions into other groups' blocks
+    std::unordered_map<Vertex*, uint> cargo_cache_group; // block group holding or receiving each cargo
+
+    // Cargo whose look ahead status may have changed, drained by Graph
+    std::vector<Vertex*> look_ahead_log;
+
+    // Prefetch statistics
+    std::unordered_set<Vertex*> prefetched_cargo;
+    uint prefetch_cnt = 0;
+    uint prefetch_hit = 0;
+
     // Parser
     Parser* parser;
 
@@ -35,6 +90,13 @@ struct Cache {
     Cache(Parser* _parser);
     ~Cache();
 
+    /**
+     * @brief Limit every group to its first size cache blocks. Used by the
+     *        cache simulator to evaluate smaller caches on the same map.
+     * @param size maximum number of cache blocks per group
+    */
+    void shrink(const uint size);
+
     /**
      * @brief Update evicted policy statistics
      * @param group cache block group number
@@ -44,6 +106,46 @@ struct Cache {
     */
     bool _update_cache_evited_policy_statistics(const uint group, const uint index, const bool fifo_option);
 
+    /**
+     * @brief Update statistics of one evicted policy
+     * @param type evicted policy to update
+     * @param group cache block group number
+     * @param index An index used for lru/fifo policy
+     * @param fifo_option An option to control fifo policy
+     * @return true if successful, false otherwise
+    */
+    bool _update_cache_evited_policy_statistics(const CacheType type, const uint group, const uint index, const bool fifo_option);
+
+    /**
+     * @brief Compare shadow caches at the end of an epoch, switch live
+     *        policy if another policy consistently gets more hits
+     * @return true if live policy is switched, false otherwise
+    */
+    bool _update_adaptive_cache_policy();
+
+    /**
+     * @brief Rebalance shared cache quota of each group by its misses in
+     *        the last epoch
+     * @return true if successful, false otherwise
+    */
+    bool _update_shared_cache_quota();
+
+    /**
+     * @brief Get number of cache blocks, in all groups, holding or reserved
+     *        for cargo of a group
+     * @param group cargo group number
+     * @return number of used cache blocks
+    */
+    uint _get_shared_cache_usage(const uint group);
+
+    /**
+     * @brief Get groups whose cache blocks can take cargo of a group, own
+     *        group first, then neighboring groups if under quota
+     * @param group cargo group number
+     * @return cache block group numbers in preference order
+    */
+    std::vector<int> _get_cache_insert_groups(const int group);
+
     /**
      * @brief Get index of evicted cache block
      * @param group cache block group number
@@ -52,12 +154,61 @@ struct Cache {
     int _get_cache_evited_policy_index(const uint group);
 
     /**
-     * @brief Get the index of a specified cache block.
+     * @brief Get candidates of evicted cache block, in evicted policy order
+     * @param group cache block group number
+     * @param num maximum number of candidates
+     * @return indexes of candidate cache blocks, empty if all blocks are locked
+    */
+    std::vector<int> _get_cache_evited_policy_candidates(const uint group, const uint num);
+
+    /**
+     * @brief Update evicted policy ghost lists when a cache block is chosen
+     *        to be cleared (ARC only)
+     * @param group cache block group number
+     * @param index index of the evicted cache block
+     * @return true if successful, false otherwise
+    */
+    bool _update_cache_evited_policy_ghost(const uint group, const uint index);
+
+    /**
+     * @brief TinyLFU admission filter, check if cargo is worth evicting victim
+     * @param cargo A pointer to the Vertex representing the new cargo.
+     * @param victim A pointer to the Vertex representing the evicted cargo.
+     * @return true if cargo is requested more often than victim, or false.
+    */
+    bool _is_admitted(Vertex* cargo, Vertex* victim);
+
+    /**
+     * @brief Get the travel distance between a cache block and a vertex.
+     * @param group cache block group number
+     * @param index index of the cache block
+     * @param vertex A pointer to the Vertex.
+     * @return shortest path length.
+    */
+    int _get_cache_block_distance(const uint group, const uint index, Vertex* vertex);
+
+    /**
+     * @brief Get the index of a specified cache block, looked up in the
+     *        vertex roles of graph.
      * @param block A pointer to the Vertex representing the block.
      * @return index of the cache block.
      */
     int _get_cache_block_in_cache_position(Vertex* block);
 
+    /**
+     * @brief Get the cache block group holding or receiving a cargo.
+     * @param cargo A pointer to the Vertex representing the cargo.
+     * @return cache block group number, cargo group if not cached.
+     */
+    int _get_cargo_in_cache_group(Vertex* cargo);
+
+    /**
+     * @brief Get the cache block holding a cargo.
+     * @param cargo A pointer to the Vertex representing the cargo.
+     * @return A pointer to the cache block, nullptr if not cached.
+     */
+    Vertex* _get_cargo_cache_block(Vertex* cargo);
+
     /**
      * @brief Check if a specific cargo is cached.
      * @param cargo A pointer to the Vertex representing the cargo.
@@ -72,13 +223,26 @@ struct Cache {
     */
     bool _is_cargo_in_coming_cache(Vertex* cargo);
 
+    /**
+     * @brief Get the cache block a cargo is coming to.
+     * @param cargo A pointer to the Vertex representing the cargo.
+     * @return A pointer to the cache block, nullptr if not coming.
+    */
+    Vertex* _get_coming_cargo_cache_block(Vertex* cargo);
+
     /**
      * @brief Check if cache need a garbage collection.
-     * @param group cache block group number
+     * @param group cargo group number
      * @return true if actually needs, or false.
     */
     bool _is_garbage_collection(int group);
 
+    /**
+     * @brief Record that look ahead status of a cargo may have changed.
+     * @param cargo A pointer to the Vertex representing the cargo.
+    */
+    void _log_look_ahead_change(Vertex* cargo);
+
     /**
      * @brief Check if the cargo is in cache. Used for look ahead protocol.
      * @param cargo A pointer to the Vertex representing the cargo.
@@ -86,6 +250,12 @@ struct Cache {
     */
     bool look_ahead_cache(Vertex* cargo);
 
+    /**
+     * @brief Record a new request of cargo. Used for frequency estimation.
+     * @param cargo A pointer to the Vertex representing the cargo.
+    */
+    void record_cargo_request(Vertex* cargo);
+
     /**
      * @brief Attempt to find a cached cargo and retrieve associated goals.
      * @param cargo A pointer to the Vertex representing the cargo.
@@ -104,10 +274,14 @@ struct Cache {
     /**
      * @brief Attempt to find a garbage to free one cache block.
      * @param cargo A pointer to the Vertex representing the cargo.
+     * @param agent_position A pointer to the agent current position, used
+     *        for distance-aware selection.
+     * @param unloading_port A pointer to the unloading port, used for
+     *        distance-aware selection.
      * @return A CacheAccessResult, true if need to do garbage collection
      *         and actually find one to collect, false otherwise.
     */
-    CacheAccessResult try_cache_garbage_collection(Vertex* cargo);
+    CacheAccessResult try_cache_garbage_collection(Vertex* cargo, Vertex* agent_position = nullptr, Vertex* unloading_port = nullptr);
 
     /**
      * @brief Insert cargo into cache. This occurs when an agent brings a
@@ -118,6 +292,15 @@ struct Cache {
      */
     bool update_cargo_into_cache(Vertex* cargo, Vertex* cache_node);
 
+    /**
+     * @brief Insert prefetched cargo into cache. This occurs when an idle
+     *        agent brings predicted hot cargo to the cache.
+     * @param cargo A pointer to the Vertex representing the cargo.
+     * @param cache_node A pointer to the Vertex representing the cache goal.
+     * @return true if successful, false otherwise.
+     */
+    bool update_prefetched_cargo_into_cache(Vertex* cargo, Vertex* cache_node);
+
     /**
      * @brief Release lock when retrieving a cached cargo.
      *        This occurs when an agent reaches the cached cargo.
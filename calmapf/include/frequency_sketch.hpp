@@ -0,0 +1,37 @@
+// Frequency sketch definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+
+// Count-min sketch with 4-bit counters, used to estimate how often a cargo
+// is requested. Sixteen counters are packed into one 64-bit word, so the
+// sketch costs 8 bytes per tracked cargo. After `sample_size` increments all
+// counters are halved, which lets old popularity fade out (aging).
+struct FrequencySketch {
+    std::vector<uint64_t> table;
+    uint64_t table_mask;
+    uint sample_size;
+    uint size;
+
+    FrequencySketch(uint capacity = 16);
+
+    /**
+     * @brief Estimate request frequency of a key.
+     * @param key Key to query, e.g. cargo vertex id.
+     * @return estimated frequency, saturated at 15.
+    */
+    uint estimate(uint key) const;
+
+    /**
+     * @brief Record one request of a key, age the sketch if needed.
+     * @param key Key to record, e.g. cargo vertex id.
+    */
+    void increment(uint key);
+
+    /**
+     * @brief Halve all counters.
+    */
+    void reset();
+};
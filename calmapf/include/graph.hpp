@@ -5,18 +5,44 @@
 #include "utils.hpp"
 #include "parser.hpp"
 #include "cache.hpp"
+#include "sampler.hpp"
+#include "order_data.hpp"
+#include "look_ahead.hpp"
 #include <map>
-#include <boost/random/mersenne_twister.hpp>
-#include <boost/random/discrete_distribution.hpp>
+
+// Goals generated at a time when the look-ahead buffer runs low
+static const uint GOALS_CHUNK_SIZE = 256;
+// Steps of trip cost a goal gains each time it is passed over, used by
+// cost-aware selection
+static const int COST_AWARE_DELAY_WEIGHT = 2;
+
+// Slotting task: move hot cargo to a shelf closer to the unloading port,
+// swapping with the cold cargo stored there (nullptr for a free shelf)
+struct SlottingTask {
+  Vertex* hot = nullptr;
+  Vertex* cold = nullptr;
+  Vertex* shelf = nullptr;
+};
 
 struct Graph {
   Vertices V;                                 // without nullptr
   Vertices U;                                 // with nullptr, i.e., |U| = width * height
   Vertices unloading_ports;                   // unloading port
-  Cache* cache;                               // cache
+  Cache* cache = nullptr;                     // cache
   std::vector<Vertices> cargo_vertices;
-  std::vector<Goals> goals_queue;             // goals queue: length [ngoals], maximum [k] different goals in any [m] length sublist 
-  std::vector<std::deque<int>> goals_delay;   // goals delay: prevent cargos is delayed by look ahead 
+  std::vector<Vertices> free_shelves;         // empty storage locations of each group
+  Vertices cargo_location;                    // current shelf of each cargo, index: cargo vertex id
+  uint relocation_cnt = 0;                    // garbage dropped at another shelf
+  std::vector<uint> cargo_demand;             // requests of each cargo, index: cargo vertex id
+  std::unordered_set<Vertex*> slotting_cargo; // cargo moved by ongoing slotting tasks
+  uint slotting_cnt = 0;                      // finished slotting tasks
+  std::vector<GoalGenerator> goals_generator; // lazy goal generator of each group
+  std::vector<LookAheadQueue> goals_queue;    // goals look-ahead buffer, refilled from goals_generator
+  OrderStream* order_stream = nullptr;        // order data replayed by Replay strategy
+  std::unordered_map<uint64_t, Vertex*> replay_cargo;   // cargo of each replayed product id
+  std::vector<std::deque<Vertex*>> replay_pending;      // orders read ahead for groups whose buffer is full
+  std::vector<std::vector<int>> distance_table;   // lazy BFS distance, index: source vertex id & vertex id
+  std::vector<VertexInfo> vertex_info;        // role and slot of each vertex, index: vertex id
 
   int width;                                  // grid width
   int height;                                 // grid height
@@ -33,11 +59,29 @@ struct Graph {
 
   GraphType get_graph_type(std::string type);
   int size() const;                       // the number of vertices, |V|
+  void _build_vertex_info();              // classify vertices after loading the map
+  const VertexInfo& get_vertex_info(Vertex* v) const { return vertex_info[v->id]; }
+  bool is_port(Vertex* v) const { return vertex_info[v->id].role == VertexRole::PORT; }
+  bool is_cache_block(Vertex* v) const { return vertex_info[v->id].role == VertexRole::CACHE; }
   Vertex* random_target_vertex(int group);
-  void _fill_goals_list(int group);
-  Vertex* get_next_goal(int group, int look_ahead = 1);
+  void _fill_goals_list(int group);          // refill look-ahead buffer of a group if it runs low
+  Vertex* _get_replay_cargo(uint64_t product_id);   // cargo standing for a replayed product
+  void _sync_look_ahead_cache();             // apply cache status changes to look ahead windows
+  Vertex* get_next_goal(int group, int look_ahead = 1, Vertex* position = nullptr);
+  Vertex* _pop_cost_aware_goal(int group, int look_ahead, Vertex* position);   // cheapest look-ahead goal for an agent
+  Vertex* get_prefetch_goal(int group, const Vertices& excluded);   // predicted hot cargo to prefetch, nullptr if none
+  const std::vector<int>& get_distance_row(Vertex* source);    // BFS distance from source to all vertices
+  int get_distance(Vertex* from, Vertex* to);                  // shortest path length between two vertices
+  Vertex* get_cargo_location(Vertex* cargo);                   // shelf where cargo is stored
+  Vertex* get_garbage_shelf(Vertex* garbage, Vertex* from, Vertex* next);   // shelf to drop evicted cargo, reserved if free
+  void update_cargo_location(Vertex* cargo, Vertex* shelf);    // cargo is dropped at shelf, old shelf becomes free
+  SlottingTask get_slotting_task(int group);                   // most beneficial slotting task, hot is nullptr if none
+  void update_slotting_location(const SlottingTask& task);     // hot cargo is dropped at task shelf
+  void finish_slotting_task(const SlottingTask& task);         // release cargo of a finished slotting task
 };
 
+std::vector<double> calculate_probabilities(int n);                      // Zhang item probabilities
+
 bool is_same_config(const Config& C1, const Config& C2);          // Check equivalence of two configurations
 bool is_reach_at_least_one(const Config& C1, const Config& C2);   // Check if the solution reached at least one goal
 
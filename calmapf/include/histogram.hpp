@@ -0,0 +1,54 @@
+// Step histogram definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+
+// Sub-buckets of each power of two range, values below 2 * STEP_HISTOGRAM_SUB_BUCKETS
+// are counted exactly, larger values within 1 / STEP_HISTOGRAM_SUB_BUCKETS
+static const uint STEP_HISTOGRAM_SUB_BUCKETS = 128;
+
+// HDR-style histogram of step counts. Values are counted in log-linear
+// buckets, so memory is constant and any percentile is available at any
+// time with a single pass over the buckets.
+struct StepHistogram {
+    std::vector<uint64_t> counts;   // count of each bucket
+    uint64_t total = 0;             // recorded values
+    double sum = 0;                 // sum of recorded values
+    uint min_value = UINT_MAX;
+    uint max_value = 0;
+
+    StepHistogram();
+
+    /**
+     * @brief Record a value.
+     * @param value step count.
+    */
+    void record(uint value);
+
+    uint64_t size() const;
+    bool empty() const;
+    double mean() const;
+
+    /**
+     * @brief Get percentiles of recorded values. The percentile p is the
+     *        value at rank floor(p * size / 100) in sorted order, the
+     *        highest value of its bucket. P0 and P100 are exact.
+     * @param percents percents in [0, 100], ascending.
+     * @return value of each percent, 0 if empty.
+    */
+    std::vector<uint> percentiles(const std::vector<double>& percents) const;
+
+    /**
+     * @brief Get a percentile of recorded values.
+     * @param percent percent in [0, 100].
+     * @return value of the percent, 0 if empty.
+    */
+    uint percentile(double percent) const;
+
+    // Bucket of a value
+    static uint _get_index(uint value);
+    // Highest value counted in a bucket
+    static uint _get_highest_value(uint index);
+};
@@ -4,28 +4,79 @@
 #pragma once
 
 #include "graph.hpp"
+#include "histogram.hpp"
+#include "assignment.hpp"
 #include "parser.hpp"
 #include "utils.hpp"
 
+// Steps of queueing each agent heading to an unloading port adds, used by
+// any-port delivery
+static const int PORT_CONGESTION_WEIGHT = 4;
+
+struct Instance;
+
+// Batch state shared by the status handlers of agents reaching goals
+struct ReachContext {
+  const Config& positions;            // agent positions at the end of the solution
+  int remain_goals;
+  uint& cache_access;
+  uint& cache_hit;
+  int reached_count = 0;
+  std::vector<size_t> free_agents;    // agents finished (or cancelled) prefetching or slotting
+  std::vector<size_t> batch_agents;   // agents to assign together with batch assignment
+
+  ReachContext(const Config& _positions, int _remain_goals, uint& _cache_access, uint& _cache_hit)
+    : positions(_positions), remain_goals(_remain_goals), cache_access(_cache_access), cache_hit(_cache_hit) {}
+};
+
+// Handler of an agent reaching its goal in a status
+using StatusHandler = void (Instance::*)(size_t j, ReachContext& ctx);
+
 struct Instance {
   Graph graph;                    // graph
   Config starts;                  // initial configuration
   Config goals;                   // goal configuration, can be in warehouse block/cache block
   Config garbages;                // old goal configuration, used for trash collection
   Config cargo_goals;             // cargo goal configuration
-  std::vector<uint> cargo_cnts;   // each cargo cnts, help variable for cargo_steps
-  std::vector<uint> cargo_steps;  // each cargo steps 
+  std::vector<uint> cargo_starts; // timestep each agent started its cargo, help variable for cargo_steps
+  StepHistogram cargo_steps;      // histogram of each cargo steps
+  uint timestep = 0;              // steps executed so far
 
   // Status control:
   // 0 -> cache miss, need trash collection, going to cache to clear position (add clear lock)
   // 1 -> cache miss, no need to trash collection / has moved trash back to warehouse, going to fetch cargo
   // 2 -> cache hit, going to cache to get cargo (add read lock)
-  // 3 -> cache cleared, going to warehouse to bring back cargo
+  // 3 -> cache cleared, going to its shelf (or nearest free shelf) to bring back garbage
   // 4 -> warehouse get cargo, find empty block, going back to insert cache (get write lock)
   // 5 -> warehouse get cargo, cannot find empty block / cache get cargo / cache insert cargo, going back to unloading port
+  // 6 -> idle agent, going to warehouse to fetch predicted hot cargo for prefetching
+  // 7 -> warehouse get prefetch cargo, find empty block, going to insert cache (get write lock)
+  // 8 -> slotting, going to fetch hot cargo from its shelf
+  // 9 -> slotting, bringing hot cargo to a shelf closer to unloading port
+  // 10 -> slotting, bringing swapped cold cargo back to the old shelf of hot cargo
+  // 11 -> cache miss, cargo is coming into cache by another agent, going to its cache block to wait for it
   std::vector<uint> bit_status;
 
-  std::vector<int> agent_group;   // agents group
+  std::vector<SlottingTask> slotting_tasks;   // slotting task of each agent
+  uint slotting_request_cnt = 0;              // cargo requests since last slotting task
+  uint batch_assignment_cnt = 0;              // batches of agents matched to goals
+  int idle_agents = 0;                        // agents not carrying goals, status 6 to 10
+  Vertices prefetching_cargo;                 // cargo of status 6 agents
+
+  std::vector<Vertices> trip_cargo;   // cargo left to pick in each agent trip
+  std::vector<uint> trip_items;       // cargo picked in each agent trip
+  uint trip_cnt = 0;                  // trips delivered to unloading port
+  uint trip_item_cnt = 0;             // cargo delivered by trips
+  uint trip_step_cnt = 0;             // steps of delivered trips
+
+  // Status 1 and status 11 agents of each cargo, redirected to cache when the cargo is cached
+  std::unordered_map<Vertex*, std::vector<size_t>> fetching_agents;
+  std::unordered_map<Vertex*, std::vector<size_t>> waiting_agents;
+  uint coalesce_cnt = 0;                      // requests waiting for coming cargo
+
+  std::vector<int> agent_group;   // agents group, changes to the group of the delivery port with any-port delivery
+  std::vector<uint> port_load;    // agents heading to each unloading port, index: group
+  std::vector<uint> port_deliveries;  // trips delivered at each unloading port, index: group
   Parser* parser;                 // paras
   std::shared_ptr<spdlog::logger> instance_console;
 
@@ -40,6 +91,8 @@ struct Instance {
   void _is_valid();
   // Check if reached port
   bool is_port(Vertex* port) const;
+  // Check if any agent reached its goal, agents waiting for coming cargo do not count
+  bool is_goal_reached(const Config& C) const;
 
   // Check agents when reaching goals with cache
   uint update_on_reaching_goals_with_cache(
@@ -48,13 +101,88 @@ struct Instance {
     uint& cache_access,
     uint& cache_hit
   );
+  // Check agents when reaching goals with cache, only reached agents reported
+  // by the planner are processed
+  uint update_on_reaching_goals_with_cache(
+    std::vector<Config>& vertex_list,
+    const std::vector<size_t>& reached,
+    int remain_goals,
+    uint& cache_access,
+    uint& cache_hit
+  );
+  // Agents at their goals at the end of the solution
+  std::vector<size_t> get_reached_agents(const Config& positions) const;
+
+  // Status handlers, the first table releases locks and runs before the
+  // second one, which requires (or not requires) locks
+  static const StatusHandler RELEASE_HANDLERS[12];
+  static const StatusHandler ACQUIRE_HANDLERS[12];
+  void _on_clear_reached(size_t j, ReachContext& ctx);            // status 0
+  void _on_fetch_reached(size_t j, ReachContext& ctx);            // status 1
+  void _on_cache_get_reached(size_t j, ReachContext& ctx);        // status 2
+  void _on_garbage_reached(size_t j, ReachContext& ctx);          // status 3
+  void _on_cache_insert_reached(size_t j, ReachContext& ctx);     // status 4
+  void _on_port_reached(size_t j, ReachContext& ctx);             // status 5
+  void _on_prefetch_fetch_reached(size_t j, ReachContext& ctx);   // status 6
+  void _on_prefetch_insert_reached(size_t j, ReachContext& ctx);  // status 7
+  void _on_slotting_fetch_reached(size_t j, ReachContext& ctx);   // status 8
+  void _on_slotting_drop_reached(size_t j, ReachContext& ctx);    // status 9
+  void _on_slotting_swap_reached(size_t j, ReachContext& ctx);    // status 10
+
+  // Agent goes to fetch its cargo from warehouse, status 1
+  void _start_fetching(size_t j);
+  void _stop_fetching(size_t j);
+  // Cargo has been cached, agents waiting for it or fetching it from warehouse go to cache instead
+  void _on_cargo_cached(Vertex* cargo, ReachContext& ctx);
+
+  // Assign free agent with a new cargo goal, or a prefetch task if idle
+  void _assign_agent(size_t j, Vertex* position, int remain_goals, uint& cache_access, uint& cache_hit);
+  // Assign free agents together, agents of a group are matched to the next
+  // goals of the group by minimum total travel distance
+  void _assign_agents(const std::vector<size_t>& agents, const Config& positions, int remain_goals, uint& cache_access, uint& cache_hit);
+  // Assign idle agent with a prefetch or slotting task, false if none
+  bool _assign_idle_task(size_t j, int remain_goals);
+  // Agent has finished (or cancelled) prefetching, status 6
+  void _stop_prefetching(size_t j);
+  // Assign agent with a cargo goal, go to cache if hit, or to warehouse (always without cache)
+  void _assign_cargo(size_t j, Vertex* position, Vertex* cargo, uint& cache_access, uint& cache_hit);
+  // Request assigned cargo from cache, wait for it if coming, or go to warehouse
+  void _request_cargo(size_t j, Vertex* position, Vertex* cargo, uint& cache_hit);
+
+  // Number of cargo an agent takes for a new trip
+  int _get_trip_size(int remain_goals) const;
+  // Assign agent with the cargo of a trip, picked in nearest-neighbor order
+  void _assign_trip(size_t j, Vertex* position, const Vertices& cargo, uint& cache_access, uint& cache_hit);
+  // Assign agent with the nearest cargo left in its trip, false if none
+  bool _assign_next_trip_cargo(size_t j, Vertex* position, uint& cache_access, uint& cache_hit);
+  // Remove and return the cargo left in trip nearest to position, nullptr if none
+  Vertex* _pop_nearest_trip_cargo(size_t j, Vertex* position);
+  // Where cargo is picked, its cache block if cached, or its shelf
+  Vertex* _get_pickup_location(Vertex* cargo);
+  // Agent has picked a cargo, pick the next cargo of the trip or go back to unloading port
+  void _finish_pick(size_t j, ReachContext& ctx);
+  // Agent has delivered its trip at unloading port, update statistics
+  void _deliver_trip(size_t j, int& remain_goals, int& reached_count);
+
+  // Unloading port to deliver cargo of agent, the cargo group port, or with
+  // any-port delivery the port with the least distance and congestion
+  Vertex* _get_delivery_port(size_t j, Vertex* position);
+  // Agent goes to deliver its cargo, status 5
+  void _go_to_port(size_t j, Vertex* position);
+  // Agent has reached unloading port, it joins the port group with any-port delivery
+  void _arrive_at_port(size_t j);
 
   // Check agents when reaching goals without cache
   uint update_on_reaching_goals_without_cache(
     std::vector<Config>& vertex_list,
     int remain_goals
   );
+  uint update_on_reaching_goals_without_cache(
+    std::vector<Config>& vertex_list,
+    const std::vector<size_t>& reached,
+    int remain_goals
+  );
 
-  // Compute percentiles steps
+  // Compute P0, P25, P50, P75, P90, P95, P99, P100 steps
   std::vector<uint> compute_percentiles() const;
 };
@@ -2,11 +2,73 @@
  * post processing, e.g., calculating solution quality
  */
 #pragma once
-#include "dist_table.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
+
 #include "instance.hpp"
 #include "parser.hpp"
+#include "ring_buffer.hpp"
 #include "utils.hpp"
 
+// Step records buffered before the main loop waits for the writer thread
+static const size_t STEP_LOG_BUFFER_SIZE = 64;
+
+// Step result handed to the writer thread, vertices are grid indices
+struct StepRecord {
+    uint agents = 0;
+    std::string map_name;
+    bool solved = false;
+    int soc = 0;
+    int soc_lb = 0;
+    int makespan = 0;
+    int makespan_lb = 0;
+    int sum_of_loss = 0;
+    double comp_time_ms = 0;
+    int seed = 0;
+    bool log_short = false;
+    int width = 1;
+    std::vector<int> starts;
+    std::vector<int> goals;
+    std::vector<int> solution;  // index: timestep * agents + agent
+};
+
+// Timesteps of lifelong trajectory kept in memory before spilling to disk
+static const uint TRAJECTORY_CHUNK_SIZE = 1024;
+
+// Agent location (grid index) and status at a timestep of lifelong trajectory
+struct TrajectoryEntry {
+    int index;
+    uint status;
+};
+
+// Lifelong trajectory spill file, stored next to the visual file as
+// "<file>.spill": header followed by chunks of chunk_size timesteps, each
+// chunk holds agents runs of chunk_size entries, index: agent * chunk size
+// + timestep in chunk. The header is rewritten after every chunk, so the
+// trajectory up to the last chunk survives a crash.
+struct TrajectorySpillHeader {
+    char magic[4];              // "CALT"
+    uint32_t version;
+    uint32_t agents;
+    uint32_t chunk_size;
+    uint64_t steps;             // timesteps written, the last chunk may be partial
+};
+
+/**
+ * @brief Write the trajectory of a spill file as visualizer YAML, agent by
+ *        agent.
+ * @param spill_file path to the spill file.
+ * @param output visual output stream.
+ * @param width grid width.
+ * @param height grid height.
+ * @return false if the spill file cannot be read.
+*/
+bool write_trajectory_yaml(const std::string& spill_file, std::ostream& output, int width, int height);
+
 struct Log {
     // File output handler
     std::ofstream throughput_output_handler;
@@ -16,8 +78,31 @@ struct Log {
 
     // Solution log
     Solution step_solution;
-    Solution life_long_solution;
-    std::vector<std::vector<uint>> bit_status_log;
+
+    // Lifelong trajectory, the last chunk is kept in memory and full chunks
+    // are spilled to a binary file, index: agent * chunk size + timestep in chunk
+    std::vector<TrajectoryEntry> trajectory_chunk;
+    uint chunk_steps = 0;           // timesteps in the chunk in memory
+    uint spilled_chunks = 0;        // chunks in spill file
+    uint trajectory_steps = 0;      // timesteps of lifelong trajectory
+    std::string trajectory_spill_file;
+    std::ofstream trajectory_spill;
+
+    // Feasibility check, agent at each vertex and the occupancy clock when it
+    // was recorded, so arrays never need clearing between timesteps
+    std::vector<int> occupied_agent;
+    std::vector<uint64_t> occupied_clock;
+    uint64_t occupancy_clock = 0;
+    std::future<bool> feasibility_check;    // conflict check running on background thread
+
+    // Step log writer, formats and writes step records off the main loop,
+    // sleeps on the condition variable while the buffer is empty
+    RingBuffer<StepRecord> step_records{ STEP_LOG_BUFFER_SIZE };
+    std::atomic<bool> step_writer_done{ false };
+    std::atomic<bool> step_writer_waiting{ false };
+    std::mutex step_writer_mutex;
+    std::condition_variable step_writer_cv;
+    std::thread step_writer;
 
     // Logger
     std::shared_ptr<spdlog::logger> log_console;
@@ -26,18 +111,31 @@ struct Log {
     ~Log();
 
     void update_solution(Solution& solution, std::vector<uint> bit_status);
+    // Append a configuration to lifelong trajectory, spill the chunk when full
+    void _append_trajectory(const Config& C, const std::vector<uint>& bit_status);
+    // Write the chunk in memory to the spill file and update its header
+    void _spill_trajectory_chunk();
     bool is_feasible_solution(const Instance& ins);
+    // Check moves, vertex and swap conflicts in O(N T) with occupancy arrays
+    bool is_conflict_free(const Solution& solution, int V);
+    // Wait for the background conflict check, false if it found conflicts
+    bool wait_feasibility_check();
     int get_makespan();
     int get_path_cost(int i);  // single-agent path cost
     int get_sum_of_costs();
     int get_sum_of_loss();
-    int get_makespan_lower_bound(const Instance& ins, DistTable& D);
-    int get_sum_of_costs_lower_bound(const Instance& ins, DistTable& D);
-    void print_stats(const Instance& ins, const double comp_time_ms);
+    // Lower bounds from the distance from start to goal of each agent, reported by the planner
+    int get_makespan_lower_bound(const std::vector<int>& distances);
+    int get_sum_of_costs_lower_bound(const std::vector<int>& distances);
+    // Print stats at debug level, skipped when debug is off
+    void print_stats(const std::vector<int>& distances, const double comp_time_ms);
 
     // File output function
-    void make_step_log(const Instance& ins, const std::string& output_name, const double comp_time_ms, const std::string& map_name, const int seed, const bool log_short = false);
-    void make_life_long_log(const Instance& ins, std::string visual_name);
+    void make_step_log(const Instance& ins, const std::vector<int>& distances, const std::string& output_name, const double comp_time_ms, const std::string& map_name, const int seed, const bool log_short = false);
+    void make_life_long_log(const Instance& ins);
+    void _write_steps();                                // writer thread loop
+    void _notify_step_writer();                         // wake writer waiting on empty buffer
+    void _write_step_record(const StepRecord& record);
     void make_throughput_log(uint index, uint* start_cnt, uint make_span);
     void make_csv_log(double cache_hit_rate, uint make_span, std::vector<uint>* step_percentiles, uint ngoals, int64_t elapsed_time, bool failure);
 };
\ No newline at end of file
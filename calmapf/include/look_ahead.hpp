@@ -0,0 +1,71 @@
+// Look ahead goals queue definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+#include "cache.hpp"
+#include <set>
+
+// Goals queue of one group with an indexed look ahead window. A goal taken
+// from inside the window leaves a nullptr behind until it reaches the front.
+// Delays never increase along the queue, since passing over goals always
+// hits a prefix of the window, so each goal stores its delay minus the
+// delay of the next goal and passing over a prefix is a single update.
+struct LookAheadQueue {
+    std::deque<Vertex*> goals;              // nullptr if taken
+    std::deque<int> delay_diff;             // delay of goal minus delay of the next goal
+    uint64_t head_seq = 0;                  // sequence number of goals.front()
+    uint window_end = 0;                    // goals[0, window_end) are in window
+    uint window_size = 0;                   // goals in window not taken
+    uint num_goals = 0;                     // goals not taken
+    int front_delay = 0;                    // delay of goals.front()
+    std::set<uint64_t> cached;              // window goals in cache and not locked
+    std::unordered_map<Vertex*, std::vector<uint64_t>> window_seq;    // window goals of each cargo
+
+    void push_back(Vertex* goal);
+    void clear();
+    uint size() const;
+    bool empty() const;
+    Vertex* front() const;
+
+    /**
+     * @brief Get the delay of a goal.
+     * @param index index in goals.
+     * @return number of times the goal has been passed over.
+    */
+    int get_delay(uint index) const;
+
+    /**
+     * @brief Update cache status of window goals of a cargo.
+     * @param cargo A pointer to the Vertex representing the cargo.
+     * @param is_cached true if the cargo is in cache and not locked.
+    */
+    void update_cached(Vertex* cargo, bool is_cached);
+
+    /**
+     * @brief Add goals to the window until it holds look_ahead goals.
+     * @param look_ahead window size, the same for every call.
+     * @param cache A pointer to the cache, nullptr if there is no cache.
+    */
+    void extend_window(uint look_ahead, Cache* cache);
+
+    /**
+     * @brief Take a window goal, goals before it are passed over.
+     * @param index index in goals, must be in window and not taken.
+     * @return A pointer to the goal.
+    */
+    Vertex* take(uint index);
+
+    /**
+     * @brief Take the next goal. The first cached goal in the window is
+     *        preferred unless the front goal reaches the delay limit.
+     * @param look_ahead window size, the same for every call.
+     * @param delay_limit maximum times a goal can be passed over.
+     * @param cache A pointer to the cache, nullptr if there is no cache.
+     * @return A pointer to the goal, nullptr if the queue is empty.
+    */
+    Vertex* pop(uint look_ahead, int delay_limit, Cache* cache);
+
+    Vertex* _take(uint index);
+};
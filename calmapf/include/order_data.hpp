@@ -0,0 +1,72 @@
+// Real order data loader
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+
+// Binary sidecar of an order data file, stored next to it as
+// "<file>.freq": header followed by num_products float frequencies in
+// ascending product id order
+struct OrderDataHeader {
+    char magic[4];              // "CALF"
+    uint32_t version;           // 2: histogram of product ids present only
+    uint64_t file_hash;         // hash of the order data file content
+    uint64_t file_size;
+    uint64_t num_products;
+};
+
+/**
+ * @brief Hash a memory buffer, 8 bytes at a time.
+ * @param data pointer to the buffer.
+ * @param size buffer length in bytes.
+ * @return 64-bit hash.
+*/
+uint64_t hash_order_data(const char* data, size_t size);
+
+/**
+ * @brief Count product ids in CSV order data, one order line per row with
+ *        the product id as the first field, the header row is skipped.
+ * @param data pointer to the CSV content.
+ * @param size content length in bytes.
+ * @param total number of order lines, output.
+ * @return number of orders of each product id present, in ascending id
+ *         order, so sparse ids take no memory for the gaps.
+*/
+std::vector<uint64_t> parse_order_data(const char* data, size_t size, uint64_t& total);
+
+/**
+ * @brief Load frequency of each product from an order data file. The file
+ *        is mapped into memory and parsed in one pass, the histogram is
+ *        cached in a binary sidecar keyed by file hash and reused by later
+ *        calls in this process or later runs.
+ * @param file_path path to the CSV order data file.
+ * @return prob_v[k] = frequency of the k-th smallest product id present,
+ *         empty if the file cannot be read.
+*/
+std::vector<float> compute_frequency_from_file(std::string file_path);
+
+// Sequential reader of product ids in an order data file, in file order
+// (exports are sorted by order time). The file is mapped into memory and
+// rewinds to the first order at the end.
+struct OrderStream {
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t first = 0;               // offset of the first order line
+    size_t cursor = 0;              // offset of the next order line
+    uint rewind_cnt = 0;
+
+    OrderStream(const std::string& file_path);
+    ~OrderStream();
+    OrderStream(const OrderStream&) = delete;
+    OrderStream& operator=(const OrderStream&) = delete;
+
+    bool is_open() const;
+
+    /**
+     * @brief Read the next order.
+     * @param product_id product id of the order, output.
+     * @return true if successful, false if the file has no order.
+    */
+    bool next(uint64_t& product_id);
+};
@@ -15,6 +15,16 @@ struct Parser {
 
     int look_ahead_num;
     int delay_deadline_limit;
+    bool distance_aware_cache;
+    bool shared_cache;
+    bool garbage_relocation;
+    bool cost_aware_selection;
+    bool batch_assignment;
+    bool request_coalescing;
+    bool any_port;
+    int prefetch_window;
+    int slotting_interval;
+    int adaptive_epoch;
 
     // Goal settings
     uint num_goals;
@@ -31,6 +41,7 @@ struct Parser {
     // Agent settings
     uint num_agents;
     uint agent_capacity;
+    int trip_capacity;
 
     // Instance settings
     int random_seed;
@@ -47,6 +58,8 @@ struct Parser {
     // Log settings
     bool short_log_format;
     bool debug_log;
+    int feasibility_check_interval;
+    bool async_feasibility_check;
 
     // Logger
     std::shared_ptr<spdlog::logger> parser_console;
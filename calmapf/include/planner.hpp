@@ -59,6 +59,7 @@ struct Planner {
   Agents A;
   Agents occupied_now;   // for quick collision checking
   Agents occupied_next;  // for quick collision checking
+  std::vector<size_t> reached;  // agents at their goals at the end of the solution
 
   Planner(const Instance* _ins, const Deadline* _deadline, std::mt19937* _MT);
   Solution solve();
@@ -66,5 +67,6 @@ struct Planner {
   bool funcPIBT(Agent* ai);
 };
 
-// main function
-Solution solve(const Instance& ins, const Deadline* deadline = nullptr, std::mt19937* MT = nullptr);
+// main function, agents reaching their goals are reported in reached, and
+// the distance from start to goal of each agent in distances
+Solution solve(const Instance& ins, const Deadline* deadline = nullptr, std::mt19937* MT = nullptr, std::vector<size_t>* reached = nullptr, std::vector<int>* distances = nullptr);
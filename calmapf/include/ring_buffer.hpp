@@ -0,0 +1,51 @@
+// Ring buffer definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+#include <atomic>
+
+// Lock-free single producer single consumer ring buffer with fixed capacity.
+// The producer only writes tail and the consumer only writes head, each
+// index is published with release and read with acquire ordering.
+template <typename T>
+struct RingBuffer {
+    std::vector<T> slots;
+    const size_t capacity;
+    std::atomic<size_t> head{ 0 };  // next slot to pop, written by consumer
+    std::atomic<size_t> tail{ 0 };  // next slot to push, written by producer
+
+    RingBuffer(size_t _capacity) : slots(_capacity + 1), capacity(_capacity + 1) {}
+
+    /**
+     * @brief Push an item, producer only.
+     * @param item item, moved into the buffer if pushed.
+     * @return false if the buffer is full.
+    */
+    bool push(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t next = (t + 1) % capacity;
+        if (next == head.load(std::memory_order_acquire)) return false;
+        slots[t] = std::move(item);
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop an item, consumer only.
+     * @param item item popped.
+     * @return false if the buffer is empty.
+    */
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = std::move(slots[h]);
+        head.store((h + 1) % capacity, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
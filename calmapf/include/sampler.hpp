@@ -0,0 +1,77 @@
+// Goal sampler definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+#include <cassert>
+
+// Walker/Vose alias table, samples an index with probability proportional
+// to its weight in O(1): one uniform column plus one biased coin flip, each
+// from a single 32-bit draw of the generator.
+struct AliasSampler {
+    std::vector<double> prob;       // probability to keep the column
+    std::vector<uint32_t> threshold;    // prob scaled to 2^32, column kept if draw is below
+    std::vector<uint> alias;        // index taken otherwise
+
+    AliasSampler() = default;
+    AliasSampler(const std::vector<double>& weights);
+
+    /**
+     * @brief Sample an index.
+     * @param MT random generator.
+     * @return index in [0, number of weights).
+    */
+    uint sample(std::mt19937* MT) const;
+};
+
+// Set of vertices with O(1) insert, erase and random access by position.
+// Erase swaps the element with the last one.
+struct IndexedVertexSet {
+    Vertices items;
+    std::unordered_map<Vertex*, uint> position;
+
+    bool contains(Vertex* v) const;
+    bool insert(Vertex* v);
+    bool erase(Vertex* v);
+    uint size() const;
+    Vertex* at(uint index) const;
+};
+
+// Lazy goal generator of one group. Emits MK goals, then Zhang goals, then
+// Real goals, one at a time, so only a bounded look-ahead buffer of goals
+// needs to be kept in memory.
+struct GoalGenerator {
+    const Vertices* candidates = nullptr;   // cargo vertices of the group
+    std::mt19937* MT = nullptr;
+    std::vector<uint> remaining;            // goals left of each strategy: MK, Zhang, Real
+
+    // MK paras, maximum [k] different goals in any [m] length sublist
+    uint max_k = 0;
+    uint max_m = 0;
+    std::deque<Vertex*> sliding_window;
+    std::unordered_map<Vertex*, int> goal_count;
+    IndexedVertexSet diff_goals;
+
+    // Zhang and Real paras
+    AliasSampler zhang_sampler;
+    AliasSampler real_sampler;
+
+    GoalGenerator() = default;
+    GoalGenerator(const Vertices* _candidates, std::mt19937* _MT, const std::vector<uint>& _remaining,
+        uint _max_k, uint _max_m, const std::vector<double>& zhang_weights, const std::vector<double>& real_weights);
+
+    /**
+     * @brief Get number of goals not generated yet.
+     * @return number of goals left.
+    */
+    uint size() const;
+
+    /**
+     * @brief Generate the next goal.
+     * @return A pointer to the cargo vertex, nullptr if all goals are generated.
+    */
+    Vertex* next();
+
+    Vertex* _next_mk_goal();
+};
@@ -0,0 +1,50 @@
+// Shadow cache definition
+// Author: Zhenghong Yu
+
+#pragma once
+
+#include "utils.hpp"
+#include "frequency_sketch.hpp"
+
+// Cargo-only model of one cache group under a given eviction policy. It
+// ignores locks and travel, and only replays the request stream to count
+// how many hits the policy would get. Used by the adaptive cache to compare
+// alternative policies with the live one.
+struct ShadowCache {
+    CacheType cache_type;
+    uint capacity;
+
+    Vertices cargo;                         // cached cargo
+    std::vector<uint> stamp;                // recency (LRU, FIFO, ARC) or frequency (LFU)
+    std::vector<bool> frequent;             // ARC, cargo is in frequent list T2
+    std::deque<Vertex*> ghost_recent;       // ARC ghost list B1
+    std::deque<Vertex*> ghost_frequent;     // ARC ghost list B2
+    double target = 0;                      // ARC target size of T1
+    uint clock = 0;
+    uint aging = 0;                         // LFU accesses since last aging
+    FrequencySketch sketch;                 // TinyLFU admission
+
+    // Statistics of current epoch
+    uint hit = 0;
+    uint access = 0;
+
+    ShadowCache(CacheType _cache_type, uint _capacity, uint cargo_num);
+
+    /**
+     * @brief Get index of evicted cargo
+     * @return index of the victim
+    */
+    int _get_evicted_index();
+
+    /**
+     * @brief Replay one cargo request.
+     * @param cargo A pointer to the Vertex representing the cargo.
+     * @return true if it is a hit, false otherwise.
+    */
+    bool request(Vertex* cargo);
+
+    /**
+     * @brief Clear statistics for a new epoch, cache content is kept.
+    */
+    void reset_statistics();
+};
@@ -67,6 +67,21 @@ struct Vertex {
   }
 };
 
+// Role of a vertex in the warehouse map
+enum class VertexRole : uint8_t {
+  AISLE,
+  PORT,
+  CACHE,
+  SHELF
+};
+
+// Role and slot of a vertex, slot is its index in unloading ports, in cache
+// blocks of its group, or in cargo vertices of its group (-1 for free shelves)
+struct VertexInfo {
+  VertexRole role = VertexRole::AISLE;
+  int slot = -1;
+};
+
 // Locations for all agents
 using Vertices = std::vector<Vertex*>;
 using Goals = std::deque<Vertex*>;
@@ -120,13 +135,30 @@ enum class CacheType {
   NONE,
   LRU,
   FIFO,
-  RANDOM
+  RANDOM,
+  LFU,
+  ARC,
+  TINYLFU,
+  ADAPTIVE
 };
 
 inline bool is_cache(CacheType cache_type) {
   return cache_type != CacheType::NONE;
 }
 
+inline std::string get_cache_type_name(CacheType cache_type) {
+  switch (cache_type) {
+  case CacheType::LRU: return "LRU";
+  case CacheType::FIFO: return "FIFO";
+  case CacheType::RANDOM: return "RANDOM";
+  case CacheType::LFU: return "LFU";
+  case CacheType::ARC: return "ARC";
+  case CacheType::TINYLFU: return "TINYLFU";
+  case CacheType::ADAPTIVE: return "ADAPTIVE";
+  default: return "NONE";
+  }
+}
+
 // Cache access result
 struct CacheAccessResult {
   bool result;
@@ -186,4 +218,5 @@ enum class GoalGenerationType {
   Zhang,
   Real,
   Hybrid,
+  Replay,
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+// Minimum cost assignment implementation
+// Author: Zhenghong Yu
+
+#include "../include/assignment.hpp"
+#include <cassert>
+#include <limits>
+
+std::vector<int> solve_min_cost_assignment(const std::vector<std::vector<int>>& cost) {
+    const int n = cost.size();
+    if (n == 0) return {};
+    const int m = cost[0].size();
+    assert(n <= m);
+
+    // Potentials of rows (u) and columns (v), row matched to each column
+    // (p) and previous column on the augmenting path (way), 1-indexed with
+    // column 0 as the virtual start
+    const int64_t INF = std::numeric_limits<int64_t>::max() / 2;
+    std::vector<int64_t> u(n + 1, 0), v(m + 1, 0);
+    std::vector<int> p(m + 1, 0), way(m + 1, 0);
+
+    for (int i = 1; i <= n; i++) {
+        p[0] = i;
+        int j0 = 0;
+        std::vector<int64_t> minv(m + 1, INF);
+        std::vector<bool> used(m + 1, false);
+
+        // Grow alternating tree from row i until a free column is reached
+        do {
+            used[j0] = true;
+            int i0 = p[j0];
+            int j1 = 0;
+            int64_t delta = INF;
+            for (int j = 1; j <= m; j++) {
+                if (used[j]) continue;
+                int64_t cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                }
+                else minv[j] -= delta;
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+
+        // Flip the augmenting path
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    std::vector<int> assignment(n, -1);
+    for (int j = 1; j <= m; j++) {
+        if (p[j] != 0) assignment[p[j] - 1] = j - 1;
+    }
+    return assignment;
+}
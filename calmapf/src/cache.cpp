@@ -4,6 +4,9 @@
 #include "../include/cache.hpp"
 
 Cache::Cache(Parser* _parser) : parser(_parser) {
+    // Adaptive cache starts with LRU
+    cache_type = parser->cache_type == CacheType::ADAPTIVE ? CacheType::LRU : parser->cache_type;
+
     // Set up logger
     if (auto existing_console = spdlog::get("cache"); existing_console != nullptr) cache_console = existing_console;
     else cache_console = spdlog::stderr_color_mt("cache");
@@ -13,9 +16,53 @@ Cache::Cache(Parser* _parser) : parser(_parser) {
 
 Cache::~Cache() {};
 
+void Cache::shrink(const uint size) {
+    auto limit = [&](auto& per_group) {
+        for (auto& blocks : per_group) {
+            if (blocks.size() > size) blocks.resize(size);
+        }
+        };
+    limit(node_cargo);
+    limit(node_id);
+    limit(node_coming_cargo);
+    limit(node_cargo_num);
+    limit(bit_cache_get_lock);
+    limit(bit_cache_insert_or_clear_lock);
+    limit(is_empty);
+    limit(LRU);
+    limit(FIFO);
+    limit(LFU);
+    limit(ARC);
+    limit(ARC_T2);
+    limit(node_dist);
+    for (auto& shadows : shadow) {
+        for (auto& shadow_cache : shadows) shadow_cache.capacity = std::min(shadow_cache.capacity, size);
+    }
+    block_num = 0;
+    for (auto& blocks : node_id) block_num += blocks.size();
+}
+
 bool Cache::_update_cache_evited_policy_statistics(const uint group, const uint index, const bool fifo_option) {
-    switch (parser->cache_type) {
+    if (parser->cache_type != CacheType::ADAPTIVE) return _update_cache_evited_policy_statistics(cache_type, group, index, fifo_option);
+
+    // Adaptive cache keeps statistics of all policies, so a switch takes
+    // effect at once. TinyLFU shares LRU statistics.
+    for (CacheType type : ADAPTIVE_CACHE_TYPES) {
+        if (type != CacheType::TINYLFU) _update_cache_evited_policy_statistics(type, group, index, fifo_option);
+    }
+    return true;
+}
+
+bool Cache::_update_cache_evited_policy_statistics(const CacheType type, const uint group, const uint index, const bool fifo_option) {
+    // ARC paras
+    Vertex* cargo = nullptr;
+    double capacity = node_id[group].size();
+    double b1_size = ARC_B1.empty() ? 0 : ARC_B1[group].size();
+    double b2_size = ARC_B2.empty() ? 0 : ARC_B2[group].size();
+
+    switch (type) {
     case CacheType::LRU:
+    case CacheType::TINYLFU:
         LRU_cnt[group] = LRU_cnt[group] + 1;
         LRU[group][index] = LRU_cnt[group];
         break;
@@ -27,6 +74,46 @@ bool Cache::_update_cache_evited_policy_statistics(const uint group, const uint
         break;
     case CacheType::RANDOM:
         break;
+    case CacheType::LFU:
+        // New cargo starts with frequency 1, cache hit increases frequency
+        if (fifo_option) LFU[group][index] = 1;
+        else LFU[group][index] = LFU[group][index] + 1;
+
+        // Aging: halve all frequencies every 10 * capacity accesses, so
+        // cargo which was hot long ago can be evicted
+        LFU_cnt[group] = LFU_cnt[group] + 1;
+        if (LFU_cnt[group] >= 10 * node_id[group].size()) {
+            for (auto& frequency : LFU[group]) frequency = frequency / 2;
+            LFU_cnt[group] = 0;
+        }
+        break;
+    case CacheType::ARC:
+        if (fifo_option) {
+            // Cargo comes into cache, adapt target size p with ghost hits
+            cargo = node_coming_cargo[group][index];
+            auto it_b1 = std::find(ARC_B1[group].begin(), ARC_B1[group].end(), cargo);
+            auto it_b2 = std::find(ARC_B2[group].begin(), ARC_B2[group].end(), cargo);
+            if (it_b1 != ARC_B1[group].end()) {
+                ARC_p[group] = std::min(capacity, ARC_p[group] + std::max(b2_size / b1_size, 1.0));
+                ARC_B1[group].erase(it_b1);
+                ARC_T2[group][index] = true;
+            }
+            else if (it_b2 != ARC_B2[group].end()) {
+                ARC_p[group] = std::max(0.0, ARC_p[group] - std::max(b1_size / b2_size, 1.0));
+                ARC_B2[group].erase(it_b2);
+                ARC_T2[group][index] = true;
+            }
+            else {
+                ARC_T2[group][index] = false;
+            }
+        }
+        else {
+            // Cache hit, move to frequent list
+            ARC_T2[group][index] = true;
+        }
+        ARC_cnt[group] = ARC_cnt[group] + 1;
+        ARC[group][index] = ARC_cnt[group];
+        break;
     default:
         cache_console->error("Unreachable cache state!");
         exit(1);
@@ -44,8 +131,14 @@ int Cache::_get_cache_evited_policy_index(const uint group) {
     int index = -1;
     std::vector<uint> candidate;
 
-    switch (parser->cache_type) {
+    // ARC paras
+    int t1_size = 0;
+    int t1_min_value = -1;
+    int t1_min_index = -1;
+
+    switch (cache_type) {
     case CacheType::LRU:
+    case CacheType::TINYLFU:
         for (uint i = 0; i < LRU[group].size(); i++) {
             // If it's not locked and (it's the first element or the smallest so far)
             if (bit_cache_insert_or_clear_lock[group][i] == 0 && bit_cache_get_lock[group][i] == 0 && (min_value == -1 || LRU[group][i] < min_value)) {
@@ -77,31 +170,99 @@ int Cache::_get_cache_evited_policy_index(const uint group) {
 
         index = get_random_int(&parser->MT, 0, candidate.size() - 1);
         return candidate[index];
+    case CacheType::LFU:
+        for (uint i = 0; i < LFU[group].size(); i++) {
+            // If it's not locked and (it's the first element or the least frequent so far)
+            if (bit_cache_insert_or_clear_lock[group][i] == 0 && bit_cache_get_lock[group][i] == 0 && (min_value == -1 || int(LFU[group][i]) < min_value)) {
+                min_value = LFU[group][i];
+                min_index = i;
+            }
+        }
+        return min_index;
+    case CacheType::ARC:
+        for (uint i = 0; i < ARC[group].size(); i++) {
+            if (!ARC_T2[group][i]) t1_size++;
+            // If it's not locked, record the least recent block in T1 and in T2
+            if (bit_cache_insert_or_clear_lock[group][i] == 0 && bit_cache_get_lock[group][i] == 0) {
+                if (!ARC_T2[group][i] && (t1_min_value == -1 || ARC[group][i] < t1_min_value)) {
+                    t1_min_value = ARC[group][i];
+                    t1_min_index = i;
+                }
+                else if (ARC_T2[group][i] && (min_value == -1 || ARC[group][i] < min_value)) {
+                    min_value = ARC[group][i];
+                    min_index = i;
+                }
+            }
+        }
+        // Replace from T1 when it exceeds its target size, otherwise from T2
+        if (t1_min_index != -1 && (t1_size > ARC_p[group] || min_index == -1)) return t1_min_index;
+        return min_index;
     default:
         cache_console->error("Unreachable cache state!");
         exit(1);
     }
 }
 
-int Cache::_get_cache_block_in_cache_position(Vertex* block) {
-    int index = -1;
-    for (uint i = 0; i < node_id[block->group].size(); i++) {
-        if (node_id[block->group][i] == block) {
-            index = i;
-            break;
-        }
-
+std::vector<int> Cache::_get_cache_evited_policy_candidates(const uint group, const uint num) {
+    std::vector<int> candidates;
+    // Repeatedly ask evicted policy, temporarily lock chosen blocks so the
+    // next query returns the next victim
+    for (uint i = 0; i < num; i++) {
+        int index = _get_cache_evited_policy_index(group);
+        if (index == -1) break;
+        candidates.push_back(index);
+        bit_cache_get_lock[group][index] += 1;
     }
+    for (int index : candidates) bit_cache_get_lock[group][index] -= 1;
+    return candidates;
+}
+
+bool Cache::_update_cache_evited_policy_ghost(const uint group, const uint index) {
+    if (cache_type != CacheType::ARC && parser->cache_type != CacheType::ADAPTIVE) return true;
+
+    // Remember evicted cargo, ghost lists are bounded by cache capacity
+    auto& ghost = ARC_T2[group][index] ? ARC_B2[group] : ARC_B1[group];
+    ghost.push_back(node_cargo[group][index]);
+    if (ghost.size() > node_id[group].size()) ghost.pop_front();
+    return true;
+}
+
+bool Cache::_is_admitted(Vertex* cargo, Vertex* victim) {
+    if (cache_type != CacheType::TINYLFU) return true;
+
+    uint cargo_frequency = sketch[cargo->group].estimate(cargo->id);
+    uint victim_frequency = sketch[victim->group].estimate(victim->id);
+    cache_console->debug("TinyLFU admission, cargo {} frequency {}, victim {} frequency {}", *cargo, cargo_frequency, *victim, victim_frequency);
+    return cargo_frequency > victim_frequency;
+}
+
+int Cache::_get_cache_block_distance(const uint group, const uint index, Vertex* vertex) {
+    return node_dist[group][index][vertex->id];
+}
+
+int Cache::_get_cache_block_in_cache_position(Vertex* block) {
+    const VertexInfo& info = (*vertex_info)[block->id];
     // Cache goals must in cache
-    assert(index != -1);
-    return index;
+    assert(info.role == VertexRole::CACHE);
+    return info.slot;
+}
+
+int Cache::_get_cargo_in_cache_group(Vertex* cargo) {
+    if (!parser->shared_cache) return cargo->group;
+
+    // Cargo may be in a neighboring group's block, a cargo is only inserted
+    // if it is in no block, so it is held by a single group
+    auto it = cargo_cache_group.find(cargo);
+    if (it != cargo_cache_group.end()) return it->second;
+    return cargo->group;
 }
 
 int Cache::_get_cargo_in_cache_position(Vertex* cargo) {
+    int group = _get_cargo_in_cache_group(cargo);
     int index = -2;
-    for (uint i = 0; i < node_cargo[cargo->group].size(); i++) {
-        if (node_cargo[cargo->group][i] == cargo) {
-            if (node_cargo_num[cargo->group][i] > 0) {
+    for (uint i = 0; i < node_cargo[group].size(); i++) {
+        if (node_cargo[group][i] == cargo) {
+            if (node_cargo_num[group][i] > 0) {
                 index = i;
                 break;
             }
@@ -114,34 +275,165 @@ int Cache::_get_cargo_in_cache_position(Vertex* cargo) {
     return index;
 }
 
+Vertex* Cache::_get_cargo_cache_block(Vertex* cargo) {
+    int index = _get_cargo_in_cache_position(cargo);
+    if (index < 0) return nullptr;
+    return node_id[_get_cargo_in_cache_group(cargo)][index];
+}
+
 bool Cache::_is_cargo_in_coming_cache(Vertex* cargo) {
-    for (uint i = 0; i < node_coming_cargo[cargo->group].size(); i++) {
-        if (node_coming_cargo[cargo->group][i] == cargo) {
+    int group = _get_cargo_in_cache_group(cargo);
+    for (uint i = 0; i < node_coming_cargo[group].size(); i++) {
+        if (node_coming_cargo[group][i] == cargo) {
             return true;
         }
     }
     return false;
 }
 
+Vertex* Cache::_get_coming_cargo_cache_block(Vertex* cargo) {
+    int group = _get_cargo_in_cache_group(cargo);
+    for (uint i = 0; i < node_coming_cargo[group].size(); i++) {
+        if (node_coming_cargo[group][i] == cargo) return node_id[group][i];
+    }
+    return nullptr;
+}
+
 bool Cache::_is_garbage_collection(int group) {
-    for (uint i = 0; i < is_empty[group].size(); i++) {
-        if (is_empty[group][i]) {
-            cache_console->debug("No need garbage collection");
-            return false;
+    for (int insert_group : _get_cache_insert_groups(group)) {
+        for (uint i = 0; i < is_empty[insert_group].size(); i++) {
+            if (is_empty[insert_group][i]) {
+                cache_console->debug("No need garbage collection");
+                return false;
+            }
         }
     }
     cache_console->debug("Need garbage collection");
     return true;
 }
 
+void Cache::_log_look_ahead_change(Vertex* cargo) {
+    look_ahead_log.push_back(cargo);
+}
+
 bool Cache::look_ahead_cache(Vertex* cargo) {
     int cache_index = _get_cargo_in_cache_position(cargo);
-    if (cache_index >= 0 && bit_cache_insert_or_clear_lock[cargo->group][cache_index] == 0) return true;
+    if (cache_index >= 0 && bit_cache_insert_or_clear_lock[_get_cargo_in_cache_group(cargo)][cache_index] == 0) return true;
     return false;
 }
 
+void Cache::record_cargo_request(Vertex* cargo) {
+    if (parser->cache_type == CacheType::TINYLFU || parser->cache_type == CacheType::ADAPTIVE) sketch[cargo->group].increment(cargo->id);
+    if (parser->shared_cache) {
+        if (shared_request.empty()) {
+            shared_request.resize(node_id.size(), 0);
+            shared_hit.resize(node_id.size(), 0);
+        }
+        shared_request[cargo->group]++;
+        // Rebalance every 10 * total cache blocks requests
+        if (++shared_request_cnt >= 10 * block_num) _update_shared_cache_quota();
+    }
+
+    if (parser->cache_type != CacheType::ADAPTIVE) return;
+
+    // Feed the same request stream to all shadow caches
+    for (auto& shadow_cache : shadow[cargo->group]) shadow_cache.request(cargo);
+    if (++adaptive_cnt >= uint(parser->adaptive_epoch)) _update_adaptive_cache_policy();
+}
+
+bool Cache::_update_shared_cache_quota() {
+    // Give cache blocks to groups proportional to their misses, every group
+    // keeps at least one block
+    uint total_miss = 0;
+    std::vector<uint> miss(node_id.size(), 0);
+    shared_quota.resize(node_id.size(), 0);
+    for (uint group = 0; group < node_id.size(); group++) {
+        miss[group] = shared_request[group] - std::min(shared_hit[group], shared_request[group]) + 1;
+        total_miss += miss[group];
+    }
+    for (uint group = 0; group < node_id.size(); group++) {
+        shared_quota[group] = std::max(1u, block_num * miss[group] / total_miss);
+        shared_request[group] = 0;
+        shared_hit[group] = 0;
+    }
+    shared_request_cnt = 0;
+    cache_console->debug("Shared cache quota {}, misses {}", shared_quota, miss);
+    return true;
+}
+
+uint Cache::_get_shared_cache_usage(const uint group) {
+    uint usage = 0;
+    for (uint block_group = 0; block_group < node_id.size(); block_group++) {
+        for (uint i = 0; i < node_id[block_group].size(); i++) {
+            if (is_empty[block_group][i]) continue;
+            // Reserved block counts for the coming cargo
+            Vertex* cargo = node_coming_cargo[block_group][i] != node_id[block_group][i] ? node_coming_cargo[block_group][i] : node_cargo[block_group][i];
+            if (cargo->group == int(group)) usage++;
+        }
+    }
+    return usage;
+}
+
+std::vector<int> Cache::_get_cache_insert_groups(const int group) {
+    std::vector<int> groups = { group };
+    if (!parser->shared_cache) return groups;
+
+    // Cache is fully shared until the first rebalance
+    if (shared_quota.empty()) shared_quota.resize(node_id.size(), block_num);
+    if (_get_shared_cache_usage(group) >= shared_quota[group]) return groups;
+
+    // Neighboring groups first
+    for (int distance = 1; distance < int(node_id.size()); distance++) {
+        if (group - distance >= 0) groups.push_back(group - distance);
+        if (group + distance < int(node_id.size())) groups.push_back(group + distance);
+    }
+    return groups;
+}
+
+bool Cache::_update_adaptive_cache_policy() {
+    // Sum shadow hits of each policy over all groups
+    std::vector<uint> hits(ADAPTIVE_CACHE_TYPES.size(), 0);
+    for (auto& shadows : shadow) {
+        for (uint i = 0; i < shadows.size(); i++) {
+            hits[i] += shadows[i].hit;
+            shadows[i].reset_statistics();
+        }
+    }
+    adaptive_cnt = 0;
+    adaptive_epoch_cnt++;
+
+    uint live = std::find(ADAPTIVE_CACHE_TYPES.begin(), ADAPTIVE_CACHE_TYPES.end(), cache_type) - ADAPTIVE_CACHE_TYPES.begin();
+    uint best = live;
+    for (uint i = 0; i < hits.size(); i++) {
+        if (hits[i] > hits[best]) best = i;
+    }
+    cache_console->debug("Adaptive epoch {}, live policy {}, shadow hits {}", adaptive_epoch_cnt, get_cache_type_name(cache_type), hits);
+
+    // Live policy is still the best
+    if (best == live) {
+        adaptive_leader = CacheType::NONE;
+        adaptive_lead = 0;
+        return false;
+    }
+
+    // Switch only when the same policy wins several epochs in a row
+    if (ADAPTIVE_CACHE_TYPES[best] == adaptive_leader) adaptive_lead++;
+    else {
+        adaptive_leader = ADAPTIVE_CACHE_TYPES[best];
+        adaptive_lead = 1;
+    }
+    if (adaptive_lead < 3) return false;
+
+    cache_console->info("Adaptive epoch {}, switch cache policy from {} to {}, shadow hits {}", adaptive_epoch_cnt, get_cache_type_name(cache_type), get_cache_type_name(adaptive_leader), hits);
+    cache_type = adaptive_leader;
+    adaptive_leader = CacheType::NONE;
+    adaptive_lead = 0;
+    adaptive_switch_cnt++;
+    return true;
+}
+
 CacheAccessResult Cache::try_cache_cargo(Vertex* cargo) {
-    int group = cargo->group;
+    int group = _get_cargo_in_cache_group(cargo);
     int cache_index = _get_cargo_in_cache_position(cargo);
 
     // If we can find cargo cached, is not reserved to be replaced and is not reserved to be cleared, we go to cache and get it
@@ -153,8 +445,13 @@ CacheAccessResult Cache::try_cache_cargo(Vertex* cargo) {
         bit_cache_get_lock[group][cache_index] += 1;
         // We also update cache evicted policy statistics
         _update_cache_evited_policy_statistics(group, cache_index, false);
-        // Update cargo number
+        // Update cargo number, cache block runs out of cargo at zero
         node_cargo_num[group][cache_index] -= 1;
+        if (node_cargo_num[group][cache_index] == 0) _log_look_ahead_change(cargo);
+        // Update prefetch statistics
+        if (prefetched_cargo.count(cargo)) prefetch_hit++;
+        // Update shared cache statistics
+        if (!shared_hit.empty()) shared_hit[cargo->group]++;
 
         return CacheAccessResult(true, node_id[group][cache_index]);
     }
@@ -171,36 +468,81 @@ CacheAccessResult Cache::try_insert_cache(Vertex* cargo, Vertex* unloading_port)
     // to unloading port, for simplify, we just check cache group here
     if (_get_cargo_in_cache_position(cargo) != -2 || _is_cargo_in_coming_cache(cargo)) return CacheAccessResult(false, unloading_port);
 
-    // Second try to find a empty position to insert cargo
-    for (uint i = 0; i < is_empty[group].size(); i++) {
-        if (is_empty[group][i]) {
-            cache_console->debug("Find an empty cache block with index {} {} to insert", i, *node_id[group][i]);
-            // We lock this position and update LRU info
-            bit_cache_insert_or_clear_lock[group][i] += 1;
-            // Update coming cargo info
-            node_coming_cargo[group][i] = cargo;
-            // Update cache evited policy statistics
-            _update_cache_evited_policy_statistics(group, i, true);
-            // Set the position to be used
-            is_empty[group][i] = false;
-            return CacheAccessResult(true, node_id[group][i]);
+    // Second try to find a empty position to insert cargo, distance-aware
+    // selection prefers the block closest to cargo and unloading port.
+    // Shared cache may borrow a neighboring group's block.
+    int best_index = -1;
+    int best_cost = -1;
+    for (int insert_group : _get_cache_insert_groups(cargo->group)) {
+        group = insert_group;
+        for (uint i = 0; i < is_empty[group].size(); i++) {
+            if (!is_empty[group][i]) continue;
+            if (!parser->distance_aware_cache) {
+                best_index = i;
+                break;
+            }
+            int cost = _get_cache_block_distance(group, i, cargo) + _get_cache_block_distance(group, i, unloading_port);
+            if (best_cost == -1 || cost < best_cost) {
+                best_cost = cost;
+                best_index = i;
+            }
         }
+        if (best_index != -1) break;
+    }
+
+    if (best_index != -1) {
+        if (group != cargo->group) shared_borrow_cnt++;
+        cache_console->debug("Find an empty cache block with index {} {} to insert", best_index, *node_id[group][best_index]);
+        // We lock this position and update LRU info
+        bit_cache_insert_or_clear_lock[group][best_index] += 1;
+        _log_look_ahead_change(node_cargo[group][best_index]);
+        // Update coming cargo info
+        node_coming_cargo[group][best_index] = cargo;
+        cargo_cache_group[cargo] = group;
+        // Update cache evited policy statistics
+        _update_cache_evited_policy_statistics(group, best_index, true);
+        // Set the position to be used
+        is_empty[group][best_index] = false;
+        return CacheAccessResult(true, node_id[group][best_index]);
     }
 
     // There is no empty block, we can not insert into cache
     return CacheAccessResult(false, unloading_port);
 }
 
-CacheAccessResult Cache::try_cache_garbage_collection(Vertex* cargo) {
+CacheAccessResult Cache::try_cache_garbage_collection(Vertex* cargo, Vertex* agent_position, Vertex* unloading_port) {
     int group = cargo->group;
     if (_is_garbage_collection(group)) {
         // Try to find a LRU position that is not locked
         int index = _get_cache_evited_policy_index(group);
 
+        // Distance-aware selection, among the less valuable half of blocks
+        // choose the shortest trip: agent -> block -> garbage home ->
+        // cargo -> block -> unloading port
+        if (index != -1 && parser->distance_aware_cache && agent_position != nullptr && unloading_port != nullptr) {
+            int best_cost = -1;
+            for (int candidate : _get_cache_evited_policy_candidates(group, std::max<uint>(1, node_id[group].size() / 2))) {
+                int cost = _get_cache_block_distance(group, candidate, agent_position)
+                    + _get_cache_block_distance(group, candidate, node_cargo[group][candidate])
+                    + _get_cache_block_distance(group, candidate, cargo)
+                    + _get_cache_block_distance(group, candidate, unloading_port);
+                if (best_cost == -1 || cost < best_cost) {
+                    best_cost = cost;
+                    index = candidate;
+                }
+            }
+        }
+
         // If we can find one, return the position
         if (index != -1) {
+            // Cargo requested less often than the victim is not worth an
+            // eviction trip, agent directly goes to warehouse
+            if (!_is_admitted(cargo, node_cargo[group][index])) return CacheAccessResult(false, cargo);
+
             // We lock this position
             bit_cache_insert_or_clear_lock[group][index] += 1;
+            _log_look_ahead_change(node_cargo[group][index]);
+            _update_cache_evited_policy_ghost(group, index);
             return CacheAccessResult(true, node_id[group][index], node_cargo[group][index]);
         }
 
@@ -221,14 +563,25 @@ bool Cache::update_cargo_into_cache(Vertex* cargo, Vertex* cache_node) {
 
     // Update cache
     cache_console->debug("Update cargo {} to cache block {}", *cargo, *cache_node);
+    // Cargo taken out before the block was reused leaves the cache
+    if (node_cargo[cache_node->group][cache_index] != cache_node) cargo_cache_group.erase(node_cargo[cache_node->group][cache_index]);
     node_cargo[cache_node->group][cache_index] = cargo;
+    node_coming_cargo[cache_node->group][cache_index] = cache_node;
     bit_cache_insert_or_clear_lock[cache_node->group][cache_index] -= 1;
+    _log_look_ahead_change(cargo);
     node_cargo_num[cache_node->group][cache_index] = parser->agent_capacity - 1;
     // Set it as not empty
     is_empty[cache_node->group][cache_index] = false;
     return true;
 }
 
+bool Cache::update_prefetched_cargo_into_cache(Vertex* cargo, Vertex* cache_node) {
+    if (!update_cargo_into_cache(cargo, cache_node)) return false;
+    prefetched_cargo.insert(cargo);
+    prefetch_cnt++;
+    return true;
+}
+
 bool Cache::update_cargo_from_cache(Vertex* cargo, Vertex* cache_node) {
     int cargo_index = _get_cargo_in_cache_position(cargo);
     int cache_index = _get_cache_block_in_cache_position(cache_node);
@@ -259,6 +612,12 @@ bool Cache::clear_cargo_from_cache(Vertex* cargo, Vertex* cache_node) {
     // Simply release lock and set cache block as empty
     cache_console->debug("Agents clear {} from cache {}", *cargo, *cache_node);
     bit_cache_insert_or_clear_lock[cache_node->group][cache_index] -= 1;
+    // Cleared cargo is no longer in cache, reset block to its placeholder
+    prefetched_cargo.erase(cargo);
+    cargo_cache_group.erase(cargo);
+    _log_look_ahead_change(cargo);
+    node_cargo[cache_node->group][cache_index] = cache_node;
+    node_cargo_num[cache_node->group][cache_index] = 0;
     is_empty[cache_node->group][cache_index] = true;
 
     return true;
@@ -0,0 +1,61 @@
+// Frequency sketch implementation
+// Author: Zhenghong Yu
+
+#include "../include/frequency_sketch.hpp"
+
+static const uint64_t SKETCH_SEEDS[4] = {
+    0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+    0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL };
+
+// 64-bit finalizer of MurmurHash3
+static uint64_t spread(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+FrequencySketch::FrequencySketch(uint capacity) : size(0) {
+    // One word per tracked key, rounded up to a power of two
+    uint64_t words = 1;
+    while (words < std::max(capacity, 16u)) words <<= 1;
+    table.resize(words, 0);
+    table_mask = words - 1;
+    sample_size = 10 * std::max(capacity, 16u);
+}
+
+uint FrequencySketch::estimate(uint key) const {
+    uint frequency = 15;
+    for (int i = 0; i < 4; i++) {
+        uint64_t hash = spread(key + SKETCH_SEEDS[i]);
+        uint offset = (hash & 15) << 2;
+        uint count = (table[(hash >> 4) & table_mask] >> offset) & 0xfULL;
+        frequency = std::min(frequency, count);
+    }
+    return frequency;
+}
+
+void FrequencySketch::increment(uint key) {
+    bool added = false;
+    for (int i = 0; i < 4; i++) {
+        uint64_t hash = spread(key + SKETCH_SEEDS[i]);
+        uint offset = (hash & 15) << 2;
+        uint64_t& word = table[(hash >> 4) & table_mask];
+        // Saturate at 15
+        if (((word >> offset) & 0xfULL) != 0xfULL) {
+            word += 1ULL << offset;
+            added = true;
+        }
+    }
+
+    if (added && ++size >= sample_size) reset();
+}
+
+void FrequencySketch::reset() {
+    for (auto& word : table) {
+        word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    size = size / 2;
+}
@@ -40,52 +40,26 @@ std::vector<double> calculate_probabilities(int n) {
   return probabilities;
 }
 
-// This is a general function that loads teh data file and compute the frequency of each product.
-// The frequencies will be used to generate a sequence of products.
-// The probability vector: prob_v[product_id] = frequency (0 if product_id never appears in the data).
-std::vector<float> compute_frequency_from_file(std::string file_path) {
-  int total = 0;
-  int n_line = 0;
-  int largest_idx = 0;
-  std::string line;
-  std::map<int, float> product_frequency;
-  std::vector<float> prob_v;
+/* Help function end*/
 
-  std::ifstream file(file_path);
-  if (!file.is_open()) {
-    std::cerr << "Failed to open data file." << std::endl;
-    return prob_v;
-  }
 
-  while (getline(file, line)) {
-    if (n_line == 0) {
-      n_line++;
-      continue;
-    }
-    std::stringstream ss(line);
-    std::string field;
-    getline(ss, field, ',');    // get the first element in each row (the product id).
-    int product_id = stoi(field);
-    product_frequency[product_id]++;
-    if (product_id > largest_idx) {
-      largest_idx = product_id;
-    }
-    total++;
-    n_line++;
+void Graph::_build_vertex_info()
+{
+  vertex_info.assign(V.size(), VertexInfo());
+  for (uint i = 0; i < unloading_ports.size(); i++) vertex_info[unloading_ports[i]->id] = { VertexRole::PORT, int(i) };
+  for (auto& group_cargo : cargo_vertices) {
+    for (uint i = 0; i < group_cargo.size(); i++) vertex_info[group_cargo[i]->id] = { VertexRole::SHELF, int(i) };
   }
-
-  for (auto it = product_frequency.begin(); it != product_frequency.end(); it++) {
-    it->second = it->second / total;
+  for (auto& group_shelves : free_shelves) {
+    for (auto shelf : group_shelves) vertex_info[shelf->id] = { VertexRole::SHELF, -1 };
   }
-
-  for (int i = 0;i <= largest_idx;i++) {
-    prob_v.push_back(product_frequency[i]);
+  if (cache != nullptr) {
+    for (auto& group_blocks : cache->node_id) {
+      for (uint i = 0; i < group_blocks.size(); i++) vertex_info[group_blocks[i]->id] = { VertexRole::CACHE, int(i) };
+    }
+    cache->vertex_info = &vertex_info;
   }
-
-  return prob_v;
 }
-/* Help function end*/
-
 
 Graph::~Graph()
 {
@@ -93,6 +67,7 @@ Graph::~Graph()
     if (v != nullptr) delete v;
   V.clear();
   delete cache;
+  delete order_stream;
 }
 
 // regular function to load graph
@@ -157,7 +132,6 @@ Graph::Graph(Parser* _parser) : parser(_parser)
   U = Vertices(width * height, nullptr);
   int group_cnt = 0;
   goals_queue.resize(group);
-  goals_delay.resize(group);
 
   if (is_cache(parser->cache_type)) {
     // Generate cache
@@ -167,6 +141,7 @@ Graph::Graph(Parser* _parser) : parser(_parser)
     int y = 0;
     Vertices tmp_cache_node;
     Vertices tmp_cargo_vertices;
+    Vertices tmp_free_shelves;
 
     // Read map
     while (getline(file, line)) {
@@ -183,6 +158,7 @@ Graph::Graph(Parser* _parser) : parser(_parser)
         cache->bit_cache_get_lock.emplace_back(tmp_cache_node.size(), 0);
         cache->bit_cache_insert_or_clear_lock.emplace_back(tmp_cache_node.size(), 0);
         cache->is_empty.emplace_back(tmp_cache_node.size(), true);
+        cache->block_num += tmp_cache_node.size();
         switch (parser->cache_type) {
         case CacheType::LRU:
           cache->LRU.emplace_back(tmp_cache_node.size(), 0);
@@ -194,6 +170,41 @@ Graph::Graph(Parser* _parser) : parser(_parser)
           break;
         case CacheType::RANDOM:
           break;
+        case CacheType::LFU:
+          cache->LFU.emplace_back(tmp_cache_node.size(), 0);
+          cache->LFU_cnt.push_back(0);
+          break;
+        case CacheType::ARC:
+          cache->ARC.emplace_back(tmp_cache_node.size(), 0);
+          cache->ARC_cnt.push_back(0);
+          cache->ARC_T2.emplace_back(tmp_cache_node.size(), false);
+          cache->ARC_p.push_back(0);
+          cache->ARC_B1.emplace_back();
+          cache->ARC_B2.emplace_back();
+          break;
+        case CacheType::TINYLFU:
+          cache->LRU.emplace_back(tmp_cache_node.size(), 0);
+          cache->LRU_cnt.push_back(0);
+          cache->sketch.emplace_back(tmp_cargo_vertices.size());
+          break;
+        case CacheType::ADAPTIVE:
+          // Statistics of all policies and one shadow cache per policy
+          cache->LRU.emplace_back(tmp_cache_node.size(), 0);
+          cache->LRU_cnt.push_back(0);
+          cache->FIFO.emplace_back(tmp_cache_node.size(), 0);
+          cache->FIFO_cnt.push_back(0);
+          cache->LFU.emplace_back(tmp_cache_node.size(), 0);
+          cache->LFU_cnt.push_back(0);
+          cache->ARC.emplace_back(tmp_cache_node.size(), 0);
+          cache->ARC_cnt.push_back(0);
+          cache->ARC_T2.emplace_back(tmp_cache_node.size(), false);
+          cache->ARC_p.push_back(0);
+          cache->ARC_B1.emplace_back();
+          cache->ARC_B2.emplace_back();
+          cache->sketch.emplace_back(tmp_cargo_vertices.size());
+          cache->shadow.emplace_back();
+          for (CacheType type : ADAPTIVE_CACHE_TYPES) cache->shadow.back().emplace_back(type, tmp_cache_node.size(), tmp_cargo_vertices.size());
+          break;
         default:
           graph_console->error("Unreachable cache type!");
           exit(1);
@@ -201,10 +212,12 @@ Graph::Graph(Parser* _parser) : parser(_parser)
 
         // Update cargo vertices
         cargo_vertices.push_back(tmp_cargo_vertices);
+        free_shelves.push_back(tmp_free_shelves);
 
         // Clear tmp variables
         tmp_cache_node.clear();
         tmp_cargo_vertices.clear();
+        tmp_free_shelves.clear();
 
         // Update group index
         group_cnt++;
@@ -242,6 +255,12 @@ Graph::Graph(Parser* _parser) : parser(_parser)
           tmp_cargo_vertices.push_back(v);
         }
 
+        // Record empty storage locations
+        else if (s == 'E') {
+          v->cargo = true;
+          tmp_free_shelves.push_back(v);
+        }
+
         // Record in whole map
         V.push_back(v);
         U[index] = v;
@@ -301,11 +320,20 @@ Graph::Graph(Parser* _parser) : parser(_parser)
     for (uint i = 0; i < cache->node_id.size(); i++) {
       graph_console->info("Cache blocks:     {}", cache->node_id[i]);
     }
+
+    // Distance from every cache block, used for distance-aware block selection
+    if (parser->distance_aware_cache) {
+      for (auto& blocks : cache->node_id) {
+        cache->node_dist.emplace_back();
+        for (auto block : blocks) cache->node_dist.back().push_back(get_distance_row(block));
+      }
+    }
   }
   else {
     // Tmp variables
     int y = 0;
     Vertices tmp_cargo_vertices;
+    Vertices tmp_free_shelves;
 
     while (getline(file, line)) {
       if (line.empty()) {
@@ -314,9 +342,11 @@ Graph::Graph(Parser* _parser) : parser(_parser)
 
         // Update cargo variables
         cargo_vertices.push_back(tmp_cargo_vertices);
+        free_shelves.push_back(tmp_free_shelves);
 
         // Clear tmp variables
         tmp_cargo_vertices.clear();
+        tmp_free_shelves.clear();
 
         // Update group index
         group_cnt++;
@@ -346,6 +376,12 @@ Graph::Graph(Parser* _parser) : parser(_parser)
           tmp_cargo_vertices.push_back(v);
         }
 
+        // Record empty storage locations
+        else if (s == 'E') {
+          v->cargo = true;
+          tmp_free_shelves.push_back(v);
+        }
+
         // Record in whole map
         V.push_back(v);
         U[index] = v;
@@ -404,8 +440,55 @@ Graph::Graph(Parser* _parser) : parser(_parser)
   }
 
   graph_console->info("Unloading ports:  {}", unloading_ports);
+  _build_vertex_info();
+
+  // Every cargo is stored at its own shelf at the beginning
+  cargo_location = V;
+  cargo_demand.resize(V.size(), 0);
+
   graph_console->info("Generating goals...");
 
+  // The generation method that is based on "Zhang, Y., 2016. Correlated storage assignment strategy to reduce travel distance in order picking. IFAC-PapersOnLine, 49(2), pp.30-35."
+  // A summary of the method.
+  // 10% of items have a sum of 70% probability to be selected (A-class). 20% of items with 20% probability (B-class), 70% of items with 10% (C-class)
+  // Assumptions:
+  // 1. The probability for each item decreases as the item index increases.
+  // 2. The last item in A-class has the same probability as the first item in B-class.
+  // 3. The last item in B-class has the same probability as the first item in C-class.
+  // 4. The sum of the probabilities for all A-class items,B-class items, and C-class items are 70%, 20%, and 10%, correspondingly.
+  // Real frequencies are read from the order file, truncated to the cargo of each group.
+  goals_generator.resize(group);
+  std::vector<float> real_frequency;
+  for (int i = 0; i < group; i++) {
+    if (parser->goals_gen_strategy == GoalGenerationType::Replay) continue;
+    std::vector<uint> remaining(3, 0);
+    for (uint j = 0; j < parser->strategy_num_goals.size() && j < remaining.size(); j++) {
+      if (parser->strategy_num_goals[j] != 0) remaining[j] = parser->strategy_num_goals[j] / uint(group) + 1;
+    }
+
+    std::vector<double> zhang_weights, real_weights;
+    if (remaining[1] > 0) zhang_weights = calculate_probabilities(cargo_vertices[i].size());
+    if (remaining[2] > 0) {
+      // Order data is parsed once and shared by all groups
+      if (real_frequency.empty()) real_frequency = compute_frequency_from_file(parser->real_dist_file_path);
+      real_weights.assign(real_frequency.begin(), real_frequency.begin() + std::min(real_frequency.size(), cargo_vertices[i].size()));
+      real_weights.resize(cargo_vertices[i].size(), 0.0);
+    }
+
+    goals_generator[i] = GoalGenerator(&cargo_vertices[i], &parser->MT, remaining, parser->goals_max_k, parser->goals_max_m, zhang_weights, real_weights);
+    graph_console->info("Group {} goals {}", i, goals_generator[i].size());
+  }
+
+  if (parser->goals_gen_strategy == GoalGenerationType::Replay) {
+    order_stream = new OrderStream(parser->real_dist_file_path);
+    if (!order_stream->is_open()) {
+      graph_console->error("order data file {} is not found or empty.", parser->real_dist_file_path);
+      exit(1);
+    }
+    graph_console->info("Replay orders from {}", parser->real_dist_file_path);
+    replay_pending.resize(group);
+  }
+
   for (int i = 0; i < group; i++) {
     _fill_goals_list(i);
   }
@@ -424,104 +507,261 @@ Vertex* Graph::random_target_vertex(int group) {
 }
 
 void Graph::_fill_goals_list(int group_index) {
-  for (uint i = 0; i < parser->strategy_num_goals.size(); i++) {
-    if (i == 0 && parser->strategy_num_goals[i] != 0) {
-      std::deque<Vertex*> sliding_window;
-      std::unordered_map<Vertex*, int> goal_count;
-      std::unordered_set<Vertex*> diff_goals;
-
-      while (goals_queue[group_index].size() < (uint(parser->strategy_num_goals[0] / group) + 1)) {
-        Vertex* selected_goal = random_target_vertex(group_index);
-
-        if (sliding_window.size() == parser->goals_max_m) {
-          Vertex* removed_goal = sliding_window.front();
-          sliding_window.pop_front();
-          goal_count[removed_goal]--;
-          if (goal_count[removed_goal] == 0) {
-            goal_count.erase(removed_goal);
-            diff_goals.erase(removed_goal);
-          }
-        }
-
-        if (diff_goals.size() == parser->goals_max_k) {
-          int index = get_random_int(&parser->MT, 0, parser->goals_max_k - 1);
-          auto it = diff_goals.begin();
-          std::advance(it, index);
-          selected_goal = *it;
-        }
-
-        // Update status
-        sliding_window.push_back(selected_goal);
-        goal_count[selected_goal]++;
-        diff_goals.insert(selected_goal);
-        goals_queue[group_index].push_back(selected_goal);
-        goals_delay[group_index].push_back(0);
-      }
+  // Keep enough goals for look ahead and prefetch, generate a chunk when
+  // the buffer runs low so memory does not grow with the number of goals
+  uint low_watermark = parser->look_ahead_num + parser->prefetch_window;
+  if (goals_queue[group_index].size() >= low_watermark) return;
+
+  uint target = low_watermark + GOALS_CHUNK_SIZE;
+
+  // Replay streams orders in time order, each order goes to the group
+  // of its cargo, so other groups are filled along the way up to target.
+  // Orders beyond target wait in the pending buffer of their group, so
+  // every group gets its orders in file order.
+  if (order_stream != nullptr) {
+    std::deque<Vertex*>& pending = replay_pending[group_index];
+    while (goals_queue[group_index].size() < target && !pending.empty()) {
+      goals_queue[group_index].push_back(pending.front());
+      pending.pop_front();
     }
-    // The generation method that is based on "Zhang, Y., 2016. Correlated storage assignment strategy to reduce travel distance in order picking. IFAC-PapersOnLine, 49(2), pp.30-35."
-    // A summary of the method.
-    // 10% of items have a sum of 70% probability to be selected (A-class). 20% of items with 20% probability (B-class), 70% of items with 10% (C-class)
-    // Assumptions:
-    // 1. The probability for each item decreases as the item index increases.
-    // 2. The last item in A-class has the same probability as the first item in B-class.
-    // 3. The last item in B-class has the same probability as the first item in C-class.
-    // 4. The sum of the probabilities for all A-class items,B-class items, and C-class items are 70%, 20%, and 10%, correspondingly.
-    else if (i == 1 && parser->strategy_num_goals[i] != 0) {
-      std::vector<double> item_prob = calculate_probabilities(cargo_vertices[group_index].size());
-      boost::random::discrete_distribution<> dist(item_prob);
-      for (uint i = 0; i < (parser->strategy_num_goals[1] / uint(group) + 1); i++) {
-        goals_queue[group_index].push_back(cargo_vertices[group_index][dist(parser->MT)]);
-        goals_delay[group_index].push_back(0);
-      }
+
+    // All products are known after the first pass, a group beyond them
+    // never gets an order
+    if (order_stream->rewind_cnt > 0 && replay_cargo.size() <= uint(group_index)) return;
+
+    // Stop at the end of the file if the group has too few orders
+    uint64_t product_id;
+    uint rewind_limit = order_stream->rewind_cnt + 1;
+    while (goals_queue[group_index].size() < target && order_stream->rewind_cnt < rewind_limit && order_stream->next(product_id)) {
+      Vertex* goal = _get_replay_cargo(product_id);
+      if (goals_queue[goal->group].size() < target && replay_pending[goal->group].empty()) goals_queue[goal->group].push_back(goal);
+      else replay_pending[goal->group].push_back(goal);
     }
-    else if (i == 2 && parser->strategy_num_goals[i] != 0) {
-      std::vector<float> prob_v = compute_frequency_from_file(parser->real_dist_file_path);
-      prob_v.resize(cargo_vertices[group_index].size());
-      boost::random::discrete_distribution<> dist(prob_v);
-      for (uint i = 0; i < (parser->strategy_num_goals[2] / uint(group) + 1); i++) {
-        goals_queue[group_index].push_back(cargo_vertices[group_index][dist(parser->MT)]);
-        goals_delay[group_index].push_back(0);
+    return;
+  }
+
+  while (goals_queue[group_index].size() < target) {
+    Vertex* goal = goals_generator[group_index].next();
+    if (goal == nullptr) break;
+    goals_queue[group_index].push_back(goal);
+  }
+}
+
+Vertex* Graph::_get_replay_cargo(uint64_t product_id) {
+  auto it = replay_cargo.find(product_id);
+  if (it != replay_cargo.end()) return it->second;
+
+  // Products are numbered densely by first appearance and dealt round-robin
+  // to groups, so every group gets a similar share of the demand. Products
+  // beyond the number of cargo share shelves.
+  uint index = replay_cargo.size();
+  int product_group = index % group;
+  const Vertices& candidates = cargo_vertices[product_group];
+  Vertex* cargo = candidates[(index / group) % candidates.size()];
+  replay_cargo[product_id] = cargo;
+  return cargo;
+}
+
+void Graph::_sync_look_ahead_cache() {
+  if (cache == nullptr) return;
+  for (Vertex* cargo : cache->look_ahead_log) {
+    if (cargo->group < group) goals_queue[cargo->group].update_cached(cargo, cache->look_ahead_cache(cargo));
+  }
+  cache->look_ahead_log.clear();
+}
+
+Vertex* Graph::_pop_cost_aware_goal(int group, int look_ahead, Vertex* position) {
+  LookAheadQueue& queue = goals_queue[group];
+  queue.extend_window(look_ahead, cache);
+
+  // Front goal reaches the delay limit, take it directly
+  if (queue.front_delay >= parser->delay_deadline_limit) return queue.take(0);
+
+  // Score each window goal by the trip agent -> cargo -> unloading port,
+  // cargo is picked from its cache block if cached, or from its shelf.
+  // Goals passed over before get a bonus, earlier goal wins on ties.
+  const std::vector<int>& from_agent = get_distance_row(position);
+  const std::vector<int>& to_port = get_distance_row(unloading_ports[group]);
+  int delay = queue.front_delay;
+  uint best_index = 0;
+  int best_score = INT_MAX;
+  for (uint i = 0; i < queue.window_end; i++) {
+    Vertex* goal = queue.goals[i];
+    if (goal != nullptr) {
+      Vertex* pickup = queue.cached.count(queue.head_seq + i) ? cache->_get_cargo_cache_block(goal) : get_cargo_location(goal);
+      int score = from_agent[pickup->id] + to_port[pickup->id] - COST_AWARE_DELAY_WEIGHT * delay;
+      if (score < best_score) {
+        best_score = score;
+        best_index = i;
       }
     }
+    delay -= queue.delay_diff[i];
   }
-
-  graph_console->info("Group {} goals {}", group, goals_queue[group_index].size());
+  return queue.take(best_index);
 }
 
-Vertex* Graph::get_next_goal(int group, int look_ahead) {
-  assert(goals_queue[group].size() == goals_delay[group].size());
+Vertex* Graph::get_next_goal(int group, int look_ahead, Vertex* position) {
+  _fill_goals_list(group);
   // Check if the specific group's queue is empty
   if (goals_queue[group].empty()) {
     return random_target_vertex(group);
   }
 
-  std::vector<Vertex*> temp_goals;
-  std::vector<int> temp_goals_delay;
-  int size = std::min(look_ahead, static_cast<int>(goals_queue[group].size()));
-
-  int cache_hit_index = 0;
-  for (int i = 0; i < size; ++i) {
-    Vertex* current_goal = goals_queue[group].front();
-    int current_goal_delay = goals_delay[group].front();
-    goals_queue[group].pop_front();
-    goals_delay[group].pop_front();
-    temp_goals.push_back(current_goal);
-    temp_goals_delay.push_back(current_goal_delay);
-
-    if (cache != nullptr && (cache->look_ahead_cache(current_goal) || current_goal_delay >= parser->delay_deadline_limit)) {
-      cache_hit_index = i;
-      break;
+  _sync_look_ahead_cache();
+  Vertex* selected_goal = nullptr;
+  if (parser->cost_aware_selection && cache != nullptr && position != nullptr) selected_goal = _pop_cost_aware_goal(group, look_ahead, position);
+  else selected_goal = goals_queue[group].pop(look_ahead, parser->delay_deadline_limit, cache);
+  cargo_demand[selected_goal->id]++;
+  return selected_goal;
+}
+
+Vertex* Graph::get_prefetch_goal(int group, const Vertices& excluded) {
+  // Prefetch only into empty cache blocks, never evict for prediction
+  if (cache == nullptr || cache->_is_garbage_collection(group)) return nullptr;
+  _fill_goals_list(group);
+
+  // Predict demand from upcoming goals, pick the most requested cargo
+  // which is neither cached nor coming
+  std::unordered_map<Vertex*, int> demand;
+  Vertex* selected_goal = nullptr;
+  const Goals& goals = goals_queue[group].goals;
+  int size = 0;
+  for (uint i = 0; i < goals.size() && size < parser->prefetch_window; i++) {
+    Vertex* goal = goals[i];
+    if (goal == nullptr) continue;
+    size++;
+    if (cache->_get_cargo_in_cache_position(goal) >= 0 || cache->_is_cargo_in_coming_cache(goal)) continue;
+    if (std::find(excluded.begin(), excluded.end(), goal) != excluded.end()) continue;
+    if (++demand[goal] > (selected_goal == nullptr ? 0 : demand[selected_goal])) selected_goal = goal;
+  }
+  return selected_goal;
+}
+
+const std::vector<int>& Graph::get_distance_row(Vertex* source) {
+  if (distance_table.empty()) distance_table.resize(V.size());
+  auto& row = distance_table[source->id];
+  if (!row.empty()) return row;
+
+  // BFS from source, unreachable vertices keep distance |V|
+  const int K = V.size();
+  row.assign(K, K);
+  std::queue<Vertex*> OPEN;
+  row[source->id] = 0;
+  OPEN.push(source);
+  while (!OPEN.empty()) {
+    auto n = OPEN.front();
+    OPEN.pop();
+    for (auto& m : n->neighbor) {
+      if (row[m->id] != K) continue;
+      row[m->id] = row[n->id] + 1;
+      OPEN.push(m);
     }
   }
+  return row;
+}
+
+int Graph::get_distance(Vertex* from, Vertex* to) {
+  return get_distance_row(from)[to->id];
+}
 
-  Vertex* selected_goal = temp_goals[cache_hit_index];
-  for (int i = temp_goals.size() - 1; i >= 0; i--) {
-    if (i != cache_hit_index) {
-      goals_queue[group].push_front(temp_goals[i]);
-      goals_delay[group].push_front(++temp_goals_delay[i]);
+Vertex* Graph::get_cargo_location(Vertex* cargo) {
+  return cargo_location[cargo->id];
+}
+
+Vertex* Graph::get_garbage_shelf(Vertex* garbage, Vertex* from, Vertex* next) {
+  auto& shelves = free_shelves[garbage->group];
+  if (!parser->garbage_relocation || shelves.empty()) return get_cargo_location(garbage);
+  // Cargo reserved by a slotting task keeps its shelf, the swap moves it later
+  if (slotting_cargo.count(garbage)) return get_cargo_location(garbage);
+
+  // Nearest free shelf on the way from the cache block to the next goal,
+  // reserved so no other agent drops garbage there
+  auto best = shelves.begin();
+  int best_cost = -1;
+  for (auto it = shelves.begin(); it != shelves.end(); ++it) {
+    int cost = get_distance(from, *it) + get_distance(next, *it);
+    if (best_cost == -1 || cost < best_cost) {
+      best_cost = cost;
+      best = it;
     }
   }
-  return selected_goal;
+
+  // Keep the cargo where it is if its current shelf is not farther
+  if (get_distance(from, get_cargo_location(garbage)) + get_distance(next, get_cargo_location(garbage)) <= best_cost) return get_cargo_location(garbage);
+
+  Vertex* shelf = *best;
+  shelves.erase(best);
+  return shelf;
+}
+
+void Graph::update_cargo_location(Vertex* cargo, Vertex* shelf) {
+  Vertex* old_shelf = get_cargo_location(cargo);
+  if (old_shelf == shelf) return;
+
+  // Old shelf becomes free
+  free_shelves[cargo->group].push_back(old_shelf);
+  cargo_location[cargo->id] = shelf;
+  relocation_cnt++;
+  graph_console->debug("Relocate cargo {} from shelf {} to shelf {}", *cargo, *old_shelf, *shelf);
+}
+
+SlottingTask Graph::get_slotting_task(int group) {
+  SlottingTask task;
+  Vertex* port = unloading_ports[group];
+
+  // Only the hottest cargo are worth moving
+  Vertices hot_cargo;
+  for (auto cargo : cargo_vertices[group]) {
+    if (cargo_demand[cargo->id] > 1 && !slotting_cargo.count(cargo)) hot_cargo.push_back(cargo);
+  }
+  int hot_size = std::min<int>(16, hot_cargo.size());
+  std::partial_sort(hot_cargo.begin(), hot_cargo.begin() + hot_size, hot_cargo.end(), [&](Vertex* a, Vertex* b) {
+    return cargo_demand[a->id] > cargo_demand[b->id];
+    });
+  hot_cargo.resize(hot_size);
+
+  // Benefit: saved steps per request times demand difference
+  long best_benefit = 0;
+  for (auto hot : hot_cargo) {
+    int hot_dist = get_distance(port, get_cargo_location(hot));
+    for (auto shelf : free_shelves[group]) {
+      long benefit = long(cargo_demand[hot->id]) * (hot_dist - get_distance(port, shelf));
+      if (benefit > best_benefit) {
+        best_benefit = benefit;
+        task = SlottingTask{ hot, nullptr, shelf };
+      }
+    }
+    for (auto cold : cargo_vertices[group]) {
+      if (cargo_demand[cold->id] >= cargo_demand[hot->id] || slotting_cargo.count(cold)) continue;
+      long benefit = long(cargo_demand[hot->id] - cargo_demand[cold->id]) * (hot_dist - get_distance(port, get_cargo_location(cold)));
+      if (benefit > best_benefit) {
+        best_benefit = benefit;
+        task = SlottingTask{ hot, cold, get_cargo_location(cold) };
+      }
+    }
+  }
+
+  // Reserve cargo and free shelf of the task
+  if (task.hot != nullptr) {
+    slotting_cargo.insert(task.hot);
+    if (task.cold != nullptr) slotting_cargo.insert(task.cold);
+    else free_shelves[group].erase(std::find(free_shelves[group].begin(), free_shelves[group].end(), task.shelf));
+    graph_console->debug("Slotting task, move cargo {} with demand {} to shelf {}, benefit {}", *task.hot, cargo_demand[task.hot->id], *task.shelf, best_benefit);
+  }
+  return task;
+}
+
+void Graph::update_slotting_location(const SlottingTask& task) {
+  // Old shelf of hot cargo becomes free, or takes the cold cargo
+  if (task.cold == nullptr) free_shelves[task.hot->group].push_back(get_cargo_location(task.hot));
+  else cargo_location[task.cold->id] = get_cargo_location(task.hot);
+  cargo_location[task.hot->id] = task.shelf;
+}
+
+void Graph::finish_slotting_task(const SlottingTask& task) {
+  slotting_cargo.erase(task.hot);
+  if (task.cold != nullptr) slotting_cargo.erase(task.cold);
+  slotting_cnt++;
 }
 
 bool is_same_config(const Config& C1, const Config& C2)
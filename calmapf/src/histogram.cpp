@@ -0,0 +1,69 @@
+// Step histogram implementation
+// Author: Zhenghong Yu
+
+#include "../include/histogram.hpp"
+
+// Exact buckets for [0, 2 * sub buckets), then sub buckets for each
+// following power of two up to 2^32
+static const uint SUB_BUCKET_BITS = 7;
+static const uint EXACT_BUCKETS = 2 * STEP_HISTOGRAM_SUB_BUCKETS;
+static const uint BUCKET_NUM = EXACT_BUCKETS + (32 - SUB_BUCKET_BITS - 1) * STEP_HISTOGRAM_SUB_BUCKETS;
+
+StepHistogram::StepHistogram() : counts(BUCKET_NUM, 0) {}
+
+uint StepHistogram::_get_index(uint value) {
+    if (value < EXACT_BUCKETS) return value;
+    // Position of the highest bit, value >> shift is in [sub buckets, 2 * sub buckets)
+    uint shift = 31 - __builtin_clz(value) - SUB_BUCKET_BITS;
+    return EXACT_BUCKETS + (shift - 1) * STEP_HISTOGRAM_SUB_BUCKETS + ((value >> shift) - STEP_HISTOGRAM_SUB_BUCKETS);
+}
+
+uint StepHistogram::_get_highest_value(uint index) {
+    if (index < EXACT_BUCKETS) return index;
+    uint shift = (index - EXACT_BUCKETS) / STEP_HISTOGRAM_SUB_BUCKETS + 1;
+    uint64_t lowest = uint64_t((index - EXACT_BUCKETS) % STEP_HISTOGRAM_SUB_BUCKETS + STEP_HISTOGRAM_SUB_BUCKETS) << shift;
+    return uint(std::min<uint64_t>(lowest + (uint64_t(1) << shift) - 1, UINT_MAX));
+}
+
+void StepHistogram::record(uint value) {
+    counts[_get_index(value)]++;
+    total++;
+    sum += value;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+}
+
+uint64_t StepHistogram::size() const {
+    return total;
+}
+
+bool StepHistogram::empty() const {
+    return total == 0;
+}
+
+double StepHistogram::mean() const {
+    return total == 0 ? .0 : sum / total;
+}
+
+std::vector<uint> StepHistogram::percentiles(const std::vector<double>& percents) const {
+    std::vector<uint> values(percents.size(), 0);
+    if (total == 0) return values;
+
+    uint index = 0;
+    uint64_t seen = counts[0];
+    for (size_t k = 0; k < percents.size(); k++) {
+        // Rank of the percent in sorted order, the last value for P100
+        uint64_t rank = std::min<uint64_t>(uint64_t(percents[k] * total / 100.0), total - 1);
+        if (rank == 0) values[k] = min_value;
+        else if (rank == total - 1) values[k] = max_value;
+        else {
+            while (seen <= rank) seen += counts[++index];
+            values[k] = std::min(_get_highest_value(index), max_value);
+        }
+    }
+    return values;
+}
+
+uint StepHistogram::percentile(double percent) const {
+    return percentiles({ percent })[0];
+}
@@ -2,12 +2,15 @@
 
 Instance::Instance(Parser* _parser) : graph(Graph(_parser)), parser(_parser)
 {
-  instance_console = spdlog::stderr_color_mt("instance");
+  if (auto existing_console = spdlog::get("instance"); existing_console != nullptr) instance_console = existing_console;
+  else instance_console = spdlog::stderr_color_mt("instance");
   if (parser->debug_log) instance_console->set_level(spdlog::level::debug);
   else instance_console->set_level(spdlog::level::info);
 
   const auto K = graph.size();
   assign_agent_group();
+  port_load.resize(graph.unloading_ports.size(), 0);
+  port_deliveries.resize(graph.unloading_ports.size(), 0);
 
   // set agents random start potition
   auto s_indexes = std::vector<int>(K);
@@ -26,15 +29,46 @@ Instance::Instance(Parser* _parser) : graph(Graph(_parser)), parser(_parser)
   while (true) {
     if (j >= K) return;
     Vertex* goal = graph.get_next_goal(agent_group[j]);
-    goals.push_back(goal);
+    if (is_cache(parser->cache_type)) graph.cache->record_cargo_request(goal);
+    goals.push_back(graph.get_cargo_location(goal));
     cargo_goals.push_back(goal);
     garbages.push_back(goal);
     bit_status.push_back(1);      // At the begining, the cache is empty, all agents should at status 1
-    cargo_cnts.push_back(0);
+    slotting_tasks.emplace_back();
+    cargo_starts.push_back(0);
+    trip_cargo.emplace_back();
+    trip_items.push_back(1);
     if (goals.size() == parser->num_agents) break;
     ++j;
   }
 
+  // Batch assignment gives the first goals of each group to the closest agents
+  if (parser->batch_assignment && goals.size() == parser->num_agents) {
+    for (int group = 0; group < graph.group; group++) {
+      std::vector<size_t> batch;
+      for (size_t k = 0; k < goals.size(); k++) {
+        if (agent_group[k] == group) batch.push_back(k);
+      }
+      if (batch.size() < 2) continue;
+
+      std::vector<std::vector<int>> cost(batch.size(), std::vector<int>(batch.size()));
+      for (size_t a = 0; a < batch.size(); a++) {
+        for (size_t b = 0; b < batch.size(); b++) cost[a][b] = graph.get_distance(starts[batch[a]], goals[batch[b]]);
+      }
+      std::vector<int> match = solve_min_cost_assignment(cost);
+      Config group_goals = goals, group_cargo_goals = cargo_goals;
+      for (size_t a = 0; a < batch.size(); a++) {
+        goals[batch[a]] = group_goals[batch[match[a]]];
+        cargo_goals[batch[a]] = group_cargo_goals[batch[match[a]]];
+        garbages[batch[a]] = cargo_goals[batch[a]];
+      }
+      batch_assignment_cnt++;
+    }
+  }
+
+  // Agents fetching cargo from warehouse are redirected when it is cached
+  for (size_t k = 0; k < goals.size(); k++) _start_fetching(k);
+
   // check instance
   _is_valid();
 }
@@ -52,218 +86,635 @@ uint Instance::update_on_reaching_goals_with_cache(
   int remain_goals,
   uint& cache_access,
   uint& cache_hit)
+{
+  return update_on_reaching_goals_with_cache(vertex_list, get_reached_agents(vertex_list.back()), remain_goals, cache_access, cache_hit);
+}
+
+uint Instance::update_on_reaching_goals_with_cache(
+  std::vector<Config>& vertex_list,
+  const std::vector<size_t>& reached,
+  int remain_goals,
+  uint& cache_access,
+  uint& cache_hit)
 {
   instance_console->debug("Old Goals: {}", goals);
   instance_console->debug("Remain goals:  {}", remain_goals);
   int step = vertex_list.size() - 1;
   instance_console->debug("Step length:   {}", step);
   instance_console->debug("Solution ends: {}", vertex_list[step]);
+  instance_console->debug("Reached agents: {}", reached.size());
   instance_console->debug("Status before: {}", bit_status);
-  int reached_count = 0;
 
-  // TODO: assign goals to closed free agents
+  ReachContext ctx(vertex_list[step], remain_goals, cache_access, cache_hit);
 
   // Update steps
-  for (size_t i = 0; i < vertex_list[step].size(); i++) {
-    cargo_cnts[i] += step;
-  }
-
-  // First, we check vertex which status will released lock
-  for (size_t j = 0; j < vertex_list[step].size(); ++j) {
-    if (vertex_list[step][j] == goals[j]) {
-      // Status 0 finished. ==> Status 3
-      if (bit_status[j] == 0) {
-        instance_console->debug("Agent {} status 0 -> status 3, reached cargo {} at cahe block {}, cleared", j, *garbages[j], *goals[j]);
-        bit_status[j] = 3;
-        assert(graph.cache->clear_cargo_from_cache(garbages[j], goals[j]));
-        goals[j] = garbages[j];
-      }
-      // Status 2 finished. ==> Status 5
-      // Agent has moved to cache cargo target.
-      // Update cache lock info, directly move back to unloading port.
-      else if (bit_status[j] == 2) {
-        instance_console->debug(
-          "Agent {} status 2 -> status 5, reach cached cargo {} at cache "
-          "block {}, return to unloading port",
-          j, *cargo_goals[j], *goals[j]);
-        bit_status[j] = 5;
-        assert(graph.cache->update_cargo_from_cache(cargo_goals[j], goals[j]));
-        // Update goals
-        goals[j] = graph.unloading_ports[cargo_goals[j]->group];
-      }
-      // Status 4 finished. ==> Status 5
-      // Agent has bring uncached cargo back to cache.
-      // Update cache, move to unloading port.
-      else if (bit_status[j] == 4) {
-        instance_console->debug(
-          "Agent {} status 4 -> status 5, bring cargo {} to cache block "
-          "{}, then return to unloading port",
-          j, *cargo_goals[j], *goals[j]);
-        bit_status[j] = 5;
-        assert(graph.cache->update_cargo_into_cache(cargo_goals[j], goals[j]));
-        // Update goals
-        goals[j] = graph.unloading_ports[cargo_goals[j]->group];
-      }
+  timestep += step;
+
+  // First, we check agents which status will release lock, then agents
+  // which status will require (or not require) lock
+  for (const StatusHandler* handlers : { RELEASE_HANDLERS, ACQUIRE_HANDLERS }) {
+    for (auto j : reached) {
+      if (ctx.positions[j] != goals[j] || handlers[bit_status[j]] == nullptr) continue;
+      (this->*handlers[bit_status[j]])(j, ctx);
     }
   }
 
-  // Second, we check vertex which status will require (or not require) lock
-  for (size_t j = 0; j < vertex_list[step].size(); ++j) {
-    if (bit_status[j] == 1) {
-      // Status 1 finished.
-      if (vertex_list[step][j] == goals[j]) {
-        // Agent has moved to warehouse cargo target
-        CacheAccessResult result = graph.cache->try_insert_cache(cargo_goals[j], graph.unloading_ports[agent_group[j]]);
-        // Cache is full, directly get back to unloading port.
-        // ==> Status 5
-        if (!result.result) {
-          instance_console->debug(
-            "Agent {} status 1 -> status 5, reach warehouse cargo {}, cache "
-            "is full, go back to unloading port",
-            j, *cargo_goals[j]);
-          bit_status[j] = 5;
-        }
-        // Find empty cache block, go and insert cargo into cache.
-        // ==> Status 4
-        else {
-          instance_console->debug(
-            "Agent {} status 1 -> status 4, reach warehouse cargo {}, find "
-            "cache block to insert, go to cache block {}",
-            j, *cargo_goals[j], *result.goal);
-          bit_status[j] = 4;
-        }
-        // Update goals
-        goals[j] = result.goal;
+  // Third, we assign agents which finished (or cancelled) prefetching or slotting
+  for (auto j : ctx.free_agents) {
+    idle_agents--;
+    cargo_starts[j] = timestep;
+    if (parser->batch_assignment) ctx.batch_agents.push_back(j);
+    else _assign_agent(j, ctx.positions[j], ctx.remain_goals, cache_access, cache_hit);
+  }
+  if (!ctx.batch_agents.empty()) _assign_agents(ctx.batch_agents, ctx.positions, ctx.remain_goals, cache_access, cache_hit);
+
+  starts = vertex_list[step];
+  instance_console->debug("Ends: {}", vertex_list[step]);
+  instance_console->debug("New Goals: {}", goals);
+  instance_console->debug("Status after: {}", bit_status);
+  return ctx.reached_count;
+}
+
+std::vector<size_t> Instance::get_reached_agents(const Config& positions) const
+{
+  std::vector<size_t> reached;
+  for (size_t j = 0; j < positions.size(); ++j) {
+    if (positions[j] == goals[j] && bit_status[j] != 11) reached.push_back(j);
+  }
+  return reached;
+}
+
+const StatusHandler Instance::RELEASE_HANDLERS[12] = {
+  &Instance::_on_clear_reached,             // 0
+  nullptr,                                  // 1
+  &Instance::_on_cache_get_reached,         // 2
+  nullptr,                                  // 3
+  &Instance::_on_cache_insert_reached,      // 4
+  nullptr,                                  // 5
+  nullptr,                                  // 6
+  &Instance::_on_prefetch_insert_reached,   // 7
+  nullptr,                                  // 8
+  nullptr,                                  // 9
+  nullptr,                                  // 10
+  nullptr,                                  // 11
+};
+
+const StatusHandler Instance::ACQUIRE_HANDLERS[12] = {
+  nullptr,                                  // 0
+  &Instance::_on_fetch_reached,             // 1
+  nullptr,                                  // 2
+  &Instance::_on_garbage_reached,           // 3
+  nullptr,                                  // 4
+  &Instance::_on_port_reached,              // 5
+  &Instance::_on_prefetch_fetch_reached,    // 6
+  nullptr,                                  // 7
+  &Instance::_on_slotting_fetch_reached,    // 8
+  &Instance::_on_slotting_drop_reached,     // 9
+  &Instance::_on_slotting_swap_reached,     // 10
+  nullptr,                                  // 11, redirected when cargo is cached
+};
+
+void Instance::_on_clear_reached(size_t j, ReachContext&)
+{
+  // Status 0 finished. ==> Status 3
+  instance_console->debug("Agent {} status 0 -> status 3, reached cargo {} at cahe block {}, cleared", j, *garbages[j], *goals[j]);
+  bit_status[j] = 3;
+  bool cleared = graph.cache->clear_cargo_from_cache(garbages[j], goals[j]);
+  assert(cleared);
+  if (!cleared) instance_console->error("Agent {} failed to clear cargo {} from cache block {}", j, *garbages[j], *goals[j]);
+  goals[j] = graph.get_garbage_shelf(garbages[j], goals[j], graph.get_cargo_location(cargo_goals[j]));
+}
+
+void Instance::_on_fetch_reached(size_t j, ReachContext& ctx)
+{
+  // Status 1 finished.
+  // Agent has moved to warehouse cargo target
+  _stop_fetching(j);
+  CacheAccessResult result = graph.cache->try_insert_cache(cargo_goals[j], graph.unloading_ports[agent_group[j]]);
+  // Cache is full, directly get back to unloading port.
+  // ==> Status 5
+  if (!result.result) {
+    instance_console->debug(
+      "Agent {} status 1 -> status 5, reach warehouse cargo {}, cache "
+      "is full, go back to unloading port",
+      j, *cargo_goals[j]);
+    _finish_pick(j, ctx);
+  }
+  // Find empty cache block, go and insert cargo into cache.
+  // ==> Status 4
+  else {
+    instance_console->debug(
+      "Agent {} status 1 -> status 4, reach warehouse cargo {}, find "
+      "cache block to insert, go to cache block {}",
+      j, *cargo_goals[j], *result.goal);
+    bit_status[j] = 4;
+    goals[j] = result.goal;
+  }
+}
+
+void Instance::_on_cache_get_reached(size_t j, ReachContext& ctx)
+{
+  // Status 2 finished. ==> Status 5
+  // Agent has moved to cache cargo target.
+  // Update cache lock info, directly move back to unloading port.
+  instance_console->debug(
+    "Agent {} status 2 -> status 5, reach cached cargo {} at cache "
+    "block {}, return to unloading port",
+    j, *cargo_goals[j], *goals[j]);
+  bool taken = graph.cache->update_cargo_from_cache(cargo_goals[j], goals[j]);
+  assert(taken);
+  if (!taken) instance_console->error("Agent {} failed to get cargo {} from cache block {}", j, *cargo_goals[j], *goals[j]);
+  // Update goals
+  _finish_pick(j, ctx);
+}
+
+void Instance::_on_garbage_reached(size_t j, ReachContext& ctx)
+{
+  // Status 3 finished.
+  // Agent has moved trash back to warehouse, going to fetch cargo
+  graph.update_cargo_location(garbages[j], goals[j]);
+
+  // Check if the cargo has been cached while clearing
+  CacheAccessResult result = graph.cache->try_cache_cargo(cargo_goals[j]);
+  if (result.result) {
+    instance_console->debug("Agent {} status 3 -> status 2, brought trash {} back to warehouse, cargo {} is cached, go to cache {}", j, *goals[j], *cargo_goals[j], *result.goal);
+    ctx.cache_access++;
+    ctx.cache_hit++;
+    bit_status[j] = 2;
+    goals[j] = result.goal;
+    return;
+  }
+
+  instance_console->debug("Agent {} status 3 -> status 1, brought trash {} back to warehouse, go to fetch cargo {}", j, *goals[j], *cargo_goals[j]);
+  bit_status[j] = 1;
+  goals[j] = graph.get_cargo_location(cargo_goals[j]);
+  _start_fetching(j);
+}
+
+void Instance::_on_cache_insert_reached(size_t j, ReachContext& ctx)
+{
+  // Status 4 finished. ==> Status 5
+  // Agent has bring uncached cargo back to cache.
+  // Update cache, move to unloading port.
+  instance_console->debug(
+    "Agent {} status 4 -> status 5, bring cargo {} to cache block "
+    "{}, then return to unloading port",
+    j, *cargo_goals[j], *goals[j]);
+  bool inserted = graph.cache->update_cargo_into_cache(cargo_goals[j], goals[j]);
+  assert(inserted);
+  if (inserted) _on_cargo_cached(cargo_goals[j], ctx);
+  else instance_console->error("Agent {} failed to insert cargo {} into cache block {}", j, *cargo_goals[j], *goals[j]);
+  // Update goals
+  _finish_pick(j, ctx);
+}
+
+void Instance::_on_port_reached(size_t j, ReachContext& ctx)
+{
+  // Status 5 finished.
+  _arrive_at_port(j);
+  _deliver_trip(j, ctx.remain_goals, ctx.reached_count);
+
+  instance_console->debug("Agent {} has bring {} cargo to unloading port, last cargo {}", j, trip_items[j], *cargo_goals[j]);
+  // Batch assignment waits for all agents freed in this step
+  if (parser->batch_assignment) ctx.batch_agents.push_back(j);
+  else _assign_agent(j, ctx.positions[j], ctx.remain_goals, ctx.cache_access, ctx.cache_hit);
+}
+
+void Instance::_on_prefetch_fetch_reached(size_t j, ReachContext& ctx)
+{
+  // Status 6 finished.
+  // Agent has fetched prefetch cargo from warehouse
+  _stop_prefetching(j);
+  CacheAccessResult result = graph.cache->try_insert_cache(cargo_goals[j], graph.unloading_ports[agent_group[j]]);
+  // Find empty cache block, go and insert cargo into cache.
+  // ==> Status 7
+  if (result.result) {
+    instance_console->debug(
+      "Agent {} status 6 -> status 7, reach warehouse prefetch cargo {}, "
+      "go to cache block {}",
+      j, *cargo_goals[j], *result.goal);
+    bit_status[j] = 7;
+    goals[j] = result.goal;
+  }
+  // Cargo has been cached or cache is full in the meantime, agent is free again
+  else {
+    instance_console->debug("Agent {} cancels prefetch of cargo {}", j, *cargo_goals[j]);
+    ctx.free_agents.push_back(j);
+  }
+}
+
+void Instance::_stop_prefetching(size_t j)
+{
+  prefetching_cargo.erase(std::find(prefetching_cargo.begin(), prefetching_cargo.end(), cargo_goals[j]));
+}
+
+void Instance::_on_prefetch_insert_reached(size_t j, ReachContext& ctx)
+{
+  // Status 7 finished.
+  // Agent has brought prefetch cargo to cache, it is free again.
+  instance_console->debug("Agent {} status 7, prefetch cargo {} into cache block {}", j, *cargo_goals[j], *goals[j]);
+  bool inserted = graph.cache->update_prefetched_cargo_into_cache(cargo_goals[j], goals[j]);
+  assert(inserted);
+  if (inserted) _on_cargo_cached(cargo_goals[j], ctx);
+  else instance_console->error("Agent {} failed to prefetch cargo {} into cache block {}", j, *cargo_goals[j], *goals[j]);
+  ctx.free_agents.push_back(j);
+}
+
+void Instance::_on_slotting_fetch_reached(size_t j, ReachContext&)
+{
+  // Status 8 finished. ==> Status 9
+  // Agent has fetched hot cargo, bring it closer to unloading port
+  instance_console->debug("Agent {} status 8 -> status 9, fetched hot cargo {}, go to shelf {}", j, *cargo_goals[j], *slotting_tasks[j].shelf);
+  bit_status[j] = 9;
+  goals[j] = slotting_tasks[j].shelf;
+}
+
+void Instance::_on_slotting_drop_reached(size_t j, ReachContext& ctx)
+{
+  // Status 9 finished.
+  graph.update_slotting_location(slotting_tasks[j]);
+  // Swap with cold cargo ==> Status 10
+  if (slotting_tasks[j].cold != nullptr) {
+    instance_console->debug("Agent {} status 9 -> status 10, swapped hot cargo {} with cold cargo {}", j, *cargo_goals[j], *slotting_tasks[j].cold);
+    bit_status[j] = 10;
+    goals[j] = graph.get_cargo_location(slotting_tasks[j].cold);
+  }
+  // Dropped at a free shelf, agent is free again
+  else {
+    instance_console->debug("Agent {} status 9, dropped hot cargo {} at free shelf {}", j, *cargo_goals[j], *goals[j]);
+    graph.finish_slotting_task(slotting_tasks[j]);
+    ctx.free_agents.push_back(j);
+  }
+}
+
+void Instance::_on_slotting_swap_reached(size_t j, ReachContext& ctx)
+{
+  // Status 10 finished.
+  // Agent has brought cold cargo away, it is free again
+  instance_console->debug("Agent {} status 10, dropped cold cargo {} at shelf {}", j, *slotting_tasks[j].cold, *goals[j]);
+  graph.finish_slotting_task(slotting_tasks[j]);
+  ctx.free_agents.push_back(j);
+}
+
+void Instance::_start_fetching(size_t j)
+{
+  fetching_agents[cargo_goals[j]].push_back(j);
+}
+
+void Instance::_stop_fetching(size_t j)
+{
+  auto it = fetching_agents.find(cargo_goals[j]);
+  if (it == fetching_agents.end()) return;
+  it->second.erase(std::remove(it->second.begin(), it->second.end(), j), it->second.end());
+  if (it->second.empty()) fetching_agents.erase(it);
+}
+
+void Instance::_on_cargo_cached(Vertex* cargo, ReachContext& ctx)
+{
+  // Agents waiting for the cargo get it first
+  auto waiting_it = waiting_agents.find(cargo);
+  if (waiting_it != waiting_agents.end()) {
+    std::vector<size_t> waiting = std::move(waiting_it->second);
+    waiting_agents.erase(waiting_it);
+    for (auto k : waiting) {
+      CacheAccessResult result = graph.cache->try_cache_cargo(cargo);
+      // ==> Status 2
+      if (result.result) {
+        instance_console->debug("Agent {} waited for cargo {} coming into cache {}, status 11 -> status 2", k, *cargo, *result.goal);
+        ctx.cache_hit++;
+        bit_status[k] = 2;
+        goals[k] = result.goal;
       }
-      // Status 1 yet not finished
-      else {
-        // Check if the cargo has been cached during the period
-        CacheAccessResult result = graph.cache->try_cache_cargo(cargo_goals[j]);
-        if (result.result) {
-          // We find cached cargo, go to cache
-          // ==> Status 2
-          instance_console->debug(
-            "Agent {} cache hit while moving to ware house to get cargo. Go to cache {}, status 1 -> status 2",
-            j, *cargo_goals[j], *result.goal);
-          cache_access++;
-          cache_hit++;
-          bit_status[j] = 1;
-          // Update goals and steps
-          goals[j] = result.goal;
-        }
-        // Otherwise, we do nothing for cache miss situation
+      // Cache block runs out of cargo, request it again
+      else _request_cargo(k, ctx.positions[k], cargo, ctx.cache_hit);
+    }
+  }
+
+  auto it = fetching_agents.find(cargo);
+  if (it == fetching_agents.end()) return;
+
+  std::vector<size_t> fetching;
+  for (auto k : it->second) {
+    // Agents at the warehouse are handled when processing their status
+    if (ctx.positions[k] == goals[k]) {
+      fetching.push_back(k);
+      continue;
+    }
+    CacheAccessResult result = graph.cache->try_cache_cargo(cargo);
+    if (!result.result) {
+      fetching.push_back(k);
+      continue;
+    }
+    // We find cached cargo, go to cache
+    // ==> Status 2
+    instance_console->debug(
+      "Agent {} cache hit while moving to ware house to get cargo {}. Go to cache {}, status 1 -> status 2",
+      k, *cargo, *result.goal);
+    ctx.cache_access++;
+    ctx.cache_hit++;
+    bit_status[k] = 2;
+    goals[k] = result.goal;
+  }
+
+  if (fetching.empty()) fetching_agents.erase(it);
+  else it->second = std::move(fetching);
+}
+
+void Instance::_assign_agent(size_t j, Vertex* position, int remain_goals, uint& cache_access, uint& cache_hit)
+{
+  if (_assign_idle_task(j, remain_goals)) return;
+
+  // Generate new cargo goals of a trip
+  Vertices cargo;
+  for (int k = 0; k < _get_trip_size(remain_goals); k++) {
+    slotting_request_cnt++;
+    cargo.push_back(graph.get_next_goal(agent_group[j], parser->look_ahead_num, position));
+  }
+  _assign_trip(j, position, cargo, cache_access, cache_hit);
+}
+
+void Instance::_assign_agents(const std::vector<size_t>& agents, const Config& positions, int remain_goals, uint& cache_access, uint& cache_hit)
+{
+  // Agents not taking idle tasks share the next goals of their group,
+  // idle tasks need a cache
+  std::vector<std::vector<size_t>> group_agents(graph.group);
+  for (auto j : agents) {
+    if (!is_cache(parser->cache_type) || !_assign_idle_task(j, remain_goals)) group_agents[agent_group[j]].push_back(j);
+  }
+
+  for (int group = 0; group < graph.group; group++) {
+    std::vector<size_t>& batch = group_agents[group];
+    if (batch.empty()) continue;
+
+    Vertices cargo;
+    for (auto j : batch) {
+      slotting_request_cnt++;
+      cargo.push_back(graph.get_next_goal(group, parser->look_ahead_num, positions[j]));
+    }
+
+    // Match agents to cargo by travel distance to the cargo, taken from
+    // its cache block if cached, or from its shelf
+    std::vector<int> match(batch.size(), 0);
+    if (batch.size() > 1) {
+      Vertices pickup;
+      for (auto c : cargo) pickup.push_back(_get_pickup_location(c));
+      std::vector<std::vector<int>> cost(batch.size(), std::vector<int>(cargo.size()));
+      for (size_t a = 0; a < batch.size(); a++) {
+        for (size_t b = 0; b < cargo.size(); b++) cost[a][b] = graph.get_distance(positions[batch[a]], pickup[b]);
       }
+      match = solve_min_cost_assignment(cost);
+      batch_assignment_cnt++;
     }
-    else if (bit_status[j] == 3) {
-      // Status 3 finished.
-      // Agent has moved trash back to warehouse, going to fetch cargo
-      if (vertex_list[step][j] == goals[j]) {
-        instance_console->debug("Agent {} status 3 -> status 1, brought trash {} back to warehouse, go to fetch cargo {}", j, *goals[j], *cargo_goals[j]);
-        bit_status[j] = 1;
-        goals[j] = cargo_goals[j];
+
+    // Matched cargo starts the trip of each agent
+    for (size_t a = 0; a < batch.size(); a++) {
+      Vertices trip = { cargo[match[a]] };
+      for (int k = 1; k < _get_trip_size(remain_goals); k++) {
+        slotting_request_cnt++;
+        trip.push_back(graph.get_next_goal(group, parser->look_ahead_num, positions[batch[a]]));
       }
+      _assign_trip(batch[a], positions[batch[a]], trip, cache_access, cache_hit);
+    }
+  }
+}
+
+bool Instance::_assign_idle_task(size_t j, int remain_goals)
+{
+  // Agent is idle if all remaining goals are served by other agents, it
+  // prefetches predicted hot cargo into cache instead of fetching a goal
+  // that would not be counted
+  if (parser->prefetch_window > 0 && remain_goals <= int(parser->num_agents) - 1 - idle_agents) {
+    Vertex* cargo = graph.get_prefetch_goal(agent_group[j], prefetching_cargo);
+    if (cargo != nullptr) {
+      instance_console->debug("Agent {} is idle, go to prefetch cargo {}, status {} -> status 6", j, *cargo, bit_status[j]);
+      idle_agents++;
+      cargo_goals[j] = cargo;
+      prefetching_cargo.push_back(cargo);
+      bit_status[j] = 6;
+      goals[j] = graph.get_cargo_location(cargo);
+      return true;
+    }
+  }
+
+  // Slotting task for idle agent, or periodically
+  bool is_idle = remain_goals <= int(parser->num_agents) - 1 - idle_agents;
+  if (parser->slotting_interval > 0 && (is_idle || slotting_request_cnt >= uint(parser->slotting_interval))) {
+    SlottingTask task = graph.get_slotting_task(agent_group[j]);
+    if (task.hot != nullptr) {
+      instance_console->debug("Agent {} assigned with slotting task, move cargo {} to shelf {}, status {} -> status 8", j, *task.hot, *task.shelf, bit_status[j]);
+      idle_agents++;
+      slotting_request_cnt = 0;
+      slotting_tasks[j] = task;
+      cargo_goals[j] = task.hot;
+      bit_status[j] = 8;
+      goals[j] = graph.get_cargo_location(task.hot);
+      return true;
     }
-    else if (bit_status[j] == 5) {
-      // Status 5 finished.
-      if (vertex_list[step][j] == goals[j]) {
-        if (remain_goals > 0) {
-          // Update statistics.
-          // Otherwise we still let agent go to fetch new cargo, but we do
-          // not update the statistics.
-          remain_goals--;
-          reached_count++;
-          // Record finished cargo steps
-          cargo_steps.push_back(cargo_cnts[j]);
-          cargo_cnts[j] = 0;
-        }
-
-        instance_console->debug("Agent {} has bring cargo {} to unloading port", j, *cargo_goals[j]);
-
-        // Generate new cargo goal
-        Vertex* cargo = graph.get_next_goal(agent_group[j], parser->look_ahead_num);
-        cargo_goals[j] = cargo;
-        CacheAccessResult result = graph.cache->try_cache_cargo(cargo);
-
-        // Cache hit, go to cache to get cached cargo
-        // ==> Status 2
-        if (result.result) {
-          instance_console->debug(
-            "Agent {} assigned with new cargo {}, cache hit. Go to cache {}, "
-            "status 5 -> status 2",
-            j, *cargo_goals[j], *result.goal);
-          cache_access++;
-          cache_hit++;
-          bit_status[j] = 2;
-          goals[j] = result.goal;
-        }
-        // Cache miss, go to warehouse to get cargo
-        else {
-          CacheAccessResult trash_result = graph.cache->try_cache_garbage_collection(cargo);
-          if (trash_result.result) {
-            // Need to do trash collection ==> Status 0
-            instance_console->debug(
-              "Agent {} assigned with new cargo {}, cache miss. Need to do trash collection. Go to "
-              "clear cache {}, status 5 -> status 0",
-              j, *cargo_goals[j], *trash_result.goal);
-            garbages[j] = trash_result.garbage;
-            cache_access++;
-            bit_status[j] = 0;
-          }
-          else {
-            // Directly go to warehouse ==> Status 1
-            instance_console->debug(
-              "Agent {} assigned with new cargo {}, cache miss. Go to "
-              "warehouse, status 5 -> status 1",
-              j, *cargo_goals[j]);
-            cache_access++;
-            bit_status[j] = 1;
-          }
-          goals[j] = trash_result.goal;
-        }
+  }
+
+  return false;
+}
+
+void Instance::_assign_cargo(size_t j, Vertex* position, Vertex* cargo, uint& cache_access, uint& cache_hit)
+{
+  cargo_goals[j] = cargo;
+  // Without cache, go to warehouse directly
+  if (!is_cache(parser->cache_type)) {
+    goals[j] = graph.get_cargo_location(cargo);
+    return;
+  }
+  graph.cache->record_cargo_request(cargo);
+  cache_access++;
+  _request_cargo(j, position, cargo, cache_hit);
+}
+
+void Instance::_request_cargo(size_t j, Vertex* position, Vertex* cargo, uint& cache_hit)
+{
+  CacheAccessResult result = graph.cache->try_cache_cargo(cargo);
+
+  // Cache hit, go to cache to get cached cargo
+  // ==> Status 2
+  if (result.result) {
+    instance_console->debug(
+      "Agent {} assigned with new cargo {}, cache hit. Go to cache {}, "
+      "status {} -> status 2",
+      j, *cargo_goals[j], *result.goal, bit_status[j]);
+    cache_hit++;
+    bit_status[j] = 2;
+    goals[j] = result.goal;
+    return;
+  }
+
+  // Cache miss, but cargo is coming into cache, wait for it at its cache block
+  // ==> Status 11
+  Vertex* coming_block = parser->request_coalescing ? graph.cache->_get_coming_cargo_cache_block(cargo) : nullptr;
+  if (coming_block != nullptr) {
+    instance_console->debug(
+      "Agent {} assigned with new cargo {}, cache miss, cargo is coming. Go to "
+      "cache {} and wait, status {} -> status 11",
+      j, *cargo_goals[j], *coming_block, bit_status[j]);
+    coalesce_cnt++;
+    bit_status[j] = 11;
+    goals[j] = coming_block;
+    waiting_agents[cargo].push_back(j);
+    return;
+  }
+
+  // Cache miss, go to warehouse to get cargo
+  CacheAccessResult trash_result = graph.cache->try_cache_garbage_collection(cargo, position, graph.unloading_ports[cargo->group]);
+  if (trash_result.result) {
+    // Need to do trash collection ==> Status 0
+    instance_console->debug(
+      "Agent {} assigned with new cargo {}, cache miss. Need to do trash collection. Go to "
+      "clear cache {}, status {} -> status 0",
+      j, *cargo_goals[j], *trash_result.goal, bit_status[j]);
+    garbages[j] = trash_result.garbage;
+    bit_status[j] = 0;
+    goals[j] = trash_result.goal;
+  }
+  else {
+    // Directly go to warehouse ==> Status 1
+    instance_console->debug(
+      "Agent {} assigned with new cargo {}, cache miss. Go to "
+      "warehouse, status {} -> status 1",
+      j, *cargo_goals[j], bit_status[j]);
+    bit_status[j] = 1;
+    goals[j] = graph.get_cargo_location(cargo);
+    _start_fetching(j);
+  }
+}
+
+int Instance::_get_trip_size(int remain_goals) const
+{
+  // Do not take more cargo than remaining goals
+  return std::max(1, std::min(parser->trip_capacity, remain_goals));
+}
+
+void Instance::_assign_trip(size_t j, Vertex* position, const Vertices& cargo, uint& cache_access, uint& cache_hit)
+{
+  trip_cargo[j] = cargo;
+  trip_items[j] = cargo.size();
+  _assign_next_trip_cargo(j, position, cache_access, cache_hit);
+}
+
+bool Instance::_assign_next_trip_cargo(size_t j, Vertex* position, uint& cache_access, uint& cache_hit)
+{
+  Vertex* cargo = _pop_nearest_trip_cargo(j, position);
+  if (cargo == nullptr) return false;
+  if (trip_items[j] > 1) instance_console->debug("Agent {} picks cargo {} of its trip, {} cargo left", j, *cargo, trip_cargo[j].size());
+  _assign_cargo(j, position, cargo, cache_access, cache_hit);
+  return true;
+}
+
+Vertex* Instance::_pop_nearest_trip_cargo(size_t j, Vertex* position)
+{
+  Vertices& cargo = trip_cargo[j];
+  if (cargo.empty()) return nullptr;
+
+  size_t nearest = 0;
+  if (cargo.size() > 1) {
+    int best_distance = -1;
+    for (size_t k = 0; k < cargo.size(); k++) {
+      int distance = graph.get_distance(position, _get_pickup_location(cargo[k]));
+      if (best_distance < 0 || distance < best_distance) {
+        best_distance = distance;
+        nearest = k;
       }
     }
   }
+  Vertex* next = cargo[nearest];
+  cargo.erase(cargo.begin() + nearest);
+  return next;
+}
 
-  starts = vertex_list[step];
-  instance_console->debug("Ends: {}", vertex_list[step]);
-  instance_console->debug("New Goals: {}", goals);
-  instance_console->debug("Status after: {}", bit_status);
-  return reached_count;
+Vertex* Instance::_get_pickup_location(Vertex* cargo)
+{
+  if (is_cache(parser->cache_type) && graph.cache->look_ahead_cache(cargo)) {
+    Vertex* block = graph.cache->_get_cargo_cache_block(cargo);
+    if (block != nullptr) return block;
+  }
+  return graph.get_cargo_location(cargo);
+}
+
+void Instance::_finish_pick(size_t j, ReachContext& ctx)
+{
+  // More cargo to pick in the trip
+  if (_assign_next_trip_cargo(j, ctx.positions[j], ctx.cache_access, ctx.cache_hit)) return;
+
+  // Go back to unloading port
+  // ==> Status 5
+  bit_status[j] = 5;
+  _go_to_port(j, ctx.positions[j]);
+}
+
+void Instance::_deliver_trip(size_t j, int& remain_goals, int& reached_count)
+{
+  trip_cnt++;
+  trip_item_cnt += trip_items[j];
+  trip_step_cnt += timestep - cargo_starts[j];
+
+  // Update statistics for every cargo of the trip.
+  // Otherwise we still let agent go to fetch new cargo, but we do
+  // not update the statistics.
+  for (uint k = 0; k < trip_items[j] && remain_goals > 0; k++) {
+    remain_goals--;
+    reached_count++;
+    // Record finished cargo steps
+    cargo_steps.record(timestep - cargo_starts[j]);
+  }
+  cargo_starts[j] = timestep;
 }
 
 uint Instance::update_on_reaching_goals_without_cache(
   std::vector<Config>& vertex_list,
   int remain_goals)
+{
+  return update_on_reaching_goals_without_cache(vertex_list, get_reached_agents(vertex_list.back()), remain_goals);
+}
+
+uint Instance::update_on_reaching_goals_without_cache(
+  std::vector<Config>& vertex_list,
+  const std::vector<size_t>& reached,
+  int remain_goals)
 {
   instance_console->debug("Remain goals:  {}", remain_goals);
   int step = vertex_list.size() - 1;
   instance_console->debug("Step length:   {}", step);
   instance_console->debug("Solution ends: {}", vertex_list[step]);
   int reached_count = 0;
+  std::vector<size_t> batch_agents;
 
-  for (size_t j = 0; j < vertex_list[step].size(); ++j) {
-    // Update steps
-    cargo_cnts[j] += step;
-    if (vertex_list[step][j] == goals[j]) {
-      if (is_port(goals[j])) {
-        if (remain_goals > 0) {
-          // Update statistics.
-          // Otherwise we still let agent go to fetch new cargo, but we do
-          // not update the statistics.
-          remain_goals--;
-          reached_count++;
-          // Recorded finished cargo steps
-          cargo_steps.push_back(cargo_cnts[j]);
-          cargo_cnts[j] = 0;
-        }
-        Vertex* cargo = graph.get_next_goal(agent_group[j]);
-        goals[j] = cargo;
-        cargo_goals[j] = cargo;
-      }
-      else {
-        goals[j] = graph.unloading_ports[cargo_goals[j]->group];
+  // Update steps
+  timestep += step;
+
+  for (auto j : reached) {
+    if (vertex_list[step][j] != goals[j]) continue;
+    if (is_port(goals[j])) {
+      _arrive_at_port(j);
+      _deliver_trip(j, remain_goals, reached_count);
+      // Agents freed at ports are matched to their next trips together
+      if (parser->batch_assignment) {
+        batch_agents.push_back(j);
+        continue;
       }
+      Vertices& cargo = trip_cargo[j];
+      for (int k = _get_trip_size(remain_goals); k > 0; k--) cargo.push_back(graph.get_next_goal(agent_group[j]));
+      trip_items[j] = cargo.size();
     }
+
+    // Go to the nearest cargo left in trip, or back to unloading port
+    Vertex* cargo = _pop_nearest_trip_cargo(j, vertex_list[step][j]);
+    if (cargo != nullptr) {
+      goals[j] = cargo;
+      cargo_goals[j] = cargo;
+    }
+    else _go_to_port(j, vertex_list[step][j]);
+  }
+
+  if (!batch_agents.empty()) {
+    // No cache access is counted without cache
+    uint cache_access = 0, cache_hit = 0;
+    _assign_agents(batch_agents, vertex_list[step], remain_goals, cache_access, cache_hit);
   }
 
   starts = vertex_list[step];
@@ -273,30 +724,51 @@ uint Instance::update_on_reaching_goals_without_cache(
 
 std::vector<uint> Instance::compute_percentiles() const {
   instance_console->debug("cargo step size: {}", cargo_steps.size());
-  std::vector<uint> sorted_steps(cargo_steps);
+  return cargo_steps.percentiles({ 0, 25, 50, 75, 90, 95, 99, 100 });
+}
 
-  // Calculate indices for the percentiles
-  auto idx = [&](double p) -> size_t {
-    return static_cast<size_t>(std::floor((p * sorted_steps.size()) / 100.0));
-    };
+Vertex* Instance::_get_delivery_port(size_t j, Vertex* position)
+{
+  Vertex* port = graph.unloading_ports[cargo_goals[j]->group];
+  if (!parser->any_port) return port;
 
-  std::vector<uint> percentiles;
-  std::vector<double> required_percentiles = { 0, 25, 50, 75, 90, 95, 99, 100 };
-  for (double p : required_percentiles) {
-    size_t i = idx(p);
-    // Partially sort to find the ith smallest element (percentile)
-    std::nth_element(sorted_steps.begin(), sorted_steps.begin() + i, sorted_steps.end());
-    percentiles.push_back(sorted_steps[i]);
+  // Each agent already heading to a port adds queueing steps
+  int best_cost = -1;
+  for (auto candidate : graph.unloading_ports) {
+    int cost = graph.get_distance(candidate, position) + PORT_CONGESTION_WEIGHT * port_load[candidate->group];
+    if (best_cost < 0 || cost < best_cost) {
+      best_cost = cost;
+      port = candidate;
+    }
   }
+  return port;
+}
 
-  return percentiles;
+void Instance::_go_to_port(size_t j, Vertex* position)
+{
+  goals[j] = _get_delivery_port(j, position);
+  port_load[goals[j]->group]++;
 }
 
-bool Instance::is_port(Vertex* vertex) const {
-  if (std::find(graph.unloading_ports.begin(), graph.unloading_ports.end(), vertex) != graph.unloading_ports.end()) {
-    return true;
+void Instance::_arrive_at_port(size_t j)
+{
+  if (port_load[goals[j]->group] > 0) port_load[goals[j]->group]--;
+  port_deliveries[goals[j]->group]++;
+  if (parser->any_port && agent_group[j] != goals[j]->group) {
+    instance_console->debug("Agent {} delivered at port {}, group {} -> group {}", j, *goals[j], agent_group[j], goals[j]->group);
+    agent_group[j] = goals[j]->group;
   }
-  else return false;
+}
+
+bool Instance::is_goal_reached(const Config& C) const {
+  for (size_t i = 0; i < C.size(); i++) {
+    if (C[i] == goals[i] && bit_status[i] != 11) return true;
+  }
+  return false;
+}
+
+bool Instance::is_port(Vertex* vertex) const {
+  return graph.is_port(vertex);
 }
 
 void Instance::assign_agent_group() {
@@ -1,10 +1,12 @@
 #include "../include/log.hpp"
 
-#include "../include/dist_table.hpp"
+static const char TRAJECTORY_SPILL_MAGIC[4] = { 'C', 'A', 'L', 'T' };
+static const uint32_t TRAJECTORY_SPILL_VERSION = 1;
 
 Log::Log(Parser* parser)
 {
-  log_console = spdlog::stderr_color_mt("log");
+  if (auto existing_console = spdlog::get("log"); existing_console != nullptr) log_console = existing_console;
+  else log_console = spdlog::stderr_color_mt("log");
   if (parser->debug_log) log_console->set_level(spdlog::level::debug);
   else log_console->set_level(spdlog::level::info);
 
@@ -37,9 +39,24 @@ Log::Log(Parser* parser)
     log_console->error("Failed to open file: {}", parser->output_visual_file);
     exit(1);
   }
+
+  // Lifelong trajectory spill file, created when the first chunk is written
+  trajectory_spill_file = parser->output_visual_file + ".spill";
+
+  // Start step log writer
+  step_writer = std::thread(&Log::_write_steps, this);
 }
 
 Log::~Log() {
+  // Wait for background check and step log writer
+  if (feasibility_check.valid()) feasibility_check.wait();
+  step_writer_done.store(true, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(step_writer_mutex);
+    step_writer_cv.notify_one();
+  }
+  if (step_writer.joinable()) step_writer.join();
+
   // Close file
   throughput_output_handler.close();
   csv_output_handler.close();
@@ -51,29 +68,52 @@ void Log::update_solution(Solution& solution, std::vector<uint> bit_status)
 {
   // Update step solution
   step_solution = solution;
+  if (solution.empty()) return;
 
-  // Update life long solution
-  if (life_long_solution.empty()) {
-    life_long_solution = step_solution;
-  }
-  else {
-    life_long_solution.insert(life_long_solution.end(),
-      step_solution.begin() + 1, step_solution.end());
+  // Update life long trajectory, later steps start from the last configuration
+  if (trajectory_chunk.empty()) trajectory_chunk.resize(solution.front().size() * TRAJECTORY_CHUNK_SIZE);
+  for (size_t t = (trajectory_steps == 0 ? 0 : 1); t < solution.size(); ++t) {
+    _append_trajectory(solution[t], bit_status);
   }
+}
 
-  // Update bit status life long log
-  if (bit_status_log.empty()) {
-    for (uint i = 0; i < solution.size(); i++) {
-      bit_status_log.push_back(bit_status);
-    }
+void Log::_append_trajectory(const Config& C, const std::vector<uint>& bit_status)
+{
+  for (size_t i = 0; i < C.size(); ++i) {
+    trajectory_chunk[i * TRAJECTORY_CHUNK_SIZE + chunk_steps] = { C[i]->index, bit_status[i] };
   }
-  else {
-    for (uint i = 1; i < solution.size(); i++) {
-      bit_status_log.push_back(bit_status);
+  trajectory_steps++;
+  if (++chunk_steps < TRAJECTORY_CHUNK_SIZE) return;
+
+  _spill_trajectory_chunk();
+  chunk_steps = 0;
+}
+
+void Log::_spill_trajectory_chunk()
+{
+  TrajectorySpillHeader header;
+  std::memcpy(header.magic, TRAJECTORY_SPILL_MAGIC, 4);
+  header.version = TRAJECTORY_SPILL_VERSION;
+  header.agents = trajectory_chunk.size() / TRAJECTORY_CHUNK_SIZE;
+  header.chunk_size = TRAJECTORY_CHUNK_SIZE;
+  header.steps = trajectory_steps;
+
+  if (!trajectory_spill.is_open()) {
+    trajectory_spill.open(trajectory_spill_file, std::ios::binary | std::ios::trunc);
+    if (!trajectory_spill.is_open()) {
+      log_console->error("Failed to open file: {}", trajectory_spill_file);
+      exit(1);
     }
+    trajectory_spill.write(reinterpret_cast<const char*>(&header), sizeof(header));
   }
-
-  return;
+  trajectory_spill.write(reinterpret_cast<const char*>(trajectory_chunk.data()), trajectory_chunk.size() * sizeof(TrajectoryEntry));
+  spilled_chunks++;
+
+  // Steps are only counted once their chunk is written
+  trajectory_spill.seekp(0);
+  trajectory_spill.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  trajectory_spill.seekp(0, std::ios::end);
+  trajectory_spill.flush();
 }
 
 bool Log::is_feasible_solution(const Instance& ins)
@@ -87,43 +127,80 @@ bool Log::is_feasible_solution(const Instance& ins)
   }
 
   // Check goal locations
-  if (!is_reach_at_least_one(step_solution.back(), ins.goals)) {
+  if (!ins.is_goal_reached(step_solution.back())) {
     log_console->error("invalid goals");
     return false;
   }
 
-  for (size_t t = 1; t < step_solution.size(); ++t) {
-    for (size_t i = 0; i < ins.parser->num_agents; ++i) {
-      auto v_i_from = step_solution[t - 1][i];
-      auto v_i_to = step_solution[t][i];
-      // Check connectivity
-      if (v_i_from != v_i_to &&
-        std::find(v_i_to->neighbor.begin(), v_i_to->neighbor.end(), v_i_from) == v_i_to->neighbor.end()) {
+  // Check conflicts on background thread, the result is reported at the next check
+  if (ins.parser->async_feasibility_check) {
+    bool feasible = wait_feasibility_check();
+    feasibility_check = std::async(std::launch::async, [this, solution = step_solution, V = ins.graph.size()]() {
+      return is_conflict_free(solution, V);
+      });
+    return feasible;
+  }
+
+  return is_conflict_free(step_solution, ins.graph.size());
+}
+
+bool Log::is_conflict_free(const Solution& solution, int V)
+{
+  if (solution.empty()) return true;
+  if (occupied_agent.size() != size_t(V)) {
+    occupied_agent.assign(V, -1);
+    occupied_clock.assign(V, 0);
+  }
+
+  // Record initial occupancy
+  const size_t N = solution.front().size();
+  occupancy_clock++;
+  for (size_t i = 0; i < N; ++i) {
+    occupied_agent[solution[0][i]->id] = i;
+    occupied_clock[solution[0][i]->id] = occupancy_clock;
+  }
+
+  for (size_t t = 1; t < solution.size(); ++t) {
+    // Check connectivity and swap conflicts against occupancy at t - 1
+    for (size_t i = 0; i < N; ++i) {
+      auto v_i_from = solution[t - 1][i];
+      auto v_i_to = solution[t][i];
+      if (v_i_from == v_i_to) continue;
+      if (std::find(v_i_to->neighbor.begin(), v_i_to->neighbor.end(), v_i_from) == v_i_to->neighbor.end()) {
         log_console->error("invalid move");
         return false;
       }
-
-      // Check conflicts
-      for (size_t j = i + 1; j < ins.parser->num_agents; ++j) {
-        auto v_j_from = step_solution[t - 1][j];
-        auto v_j_to = step_solution[t][j];
-        // Vertex conflicts
-        if (v_j_to == v_i_to) {
-          log_console->error("vertex conflict");
-          return false;
-        }
-        // Swap conflicts
-        if (v_j_to == v_i_from && v_j_from == v_i_to) {
+      if (occupied_clock[v_i_to->id] == occupancy_clock) {
+        int j = occupied_agent[v_i_to->id];
+        if (solution[t][j] == v_i_from) {
           log_console->error("edge conflict");
           return false;
         }
       }
     }
+
+    // Check vertex conflicts while recording occupancy at t
+    occupancy_clock++;
+    for (size_t i = 0; i < N; ++i) {
+      auto v_i_to = solution[t][i];
+      if (occupied_clock[v_i_to->id] == occupancy_clock) {
+        log_console->error("vertex conflict");
+        return false;
+      }
+      occupied_agent[v_i_to->id] = i;
+      occupied_clock[v_i_to->id] = occupancy_clock;
+    }
   }
 
   return true;
 }
 
+bool Log::wait_feasibility_check()
+{
+  if (!feasibility_check.valid()) return true;
+  return feasibility_check.get();
+}
+
 int Log::get_makespan()
 {
   if (step_solution.empty()) return 0;
@@ -163,34 +240,29 @@ int Log::get_sum_of_loss()
   return c;
 }
 
-int Log::get_makespan_lower_bound(const Instance& ins, DistTable& dist_table)
+int Log::get_makespan_lower_bound(const std::vector<int>& distances)
 {
   int c = 0;
-  for (size_t i = 0; i < ins.parser->num_agents; ++i) {
-    c = std::max(c, dist_table.get(i, ins.starts[i]));
-  }
+  for (auto d : distances) c = std::max(c, d);
   return c;
 }
 
-int Log::get_sum_of_costs_lower_bound(const Instance& ins,
-  DistTable& dist_table)
+int Log::get_sum_of_costs_lower_bound(const std::vector<int>& distances)
 {
   int c = 0;
-  for (size_t i = 0; i < ins.parser->num_agents; ++i) {
-    c += dist_table.get(i, ins.starts[i]);
-  }
+  for (auto d : distances) c += d;
   return c;
 }
 
-void Log::print_stats(const Instance& ins, const double comp_time_ms)
+void Log::print_stats(const std::vector<int>& distances, const double comp_time_ms)
 {
+  if (!log_console->should_log(spdlog::level::debug)) return;
   auto ceil = [](float x) { return std::ceil(x * 100) / 100; };
 
-  auto dist_table = DistTable(ins);
   const auto makespan = get_makespan();
-  const auto makespan_lb = get_makespan_lower_bound(ins, dist_table);
+  const auto makespan_lb = get_makespan_lower_bound(distances);
   const auto sum_of_costs = get_sum_of_costs();
-  const auto sum_of_costs_lb = get_sum_of_costs_lower_bound(ins, dist_table);
+  const auto sum_of_costs_lb = get_sum_of_costs_lower_bound(distances);
   const auto sum_of_loss = get_sum_of_loss();
 
   log_console->debug(
@@ -206,94 +278,163 @@ void Log::print_stats(const Instance& ins, const double comp_time_ms)
 // for log of map_name
 static const std::regex r_map_name = std::regex(R"(.+/(.+))");
 
-void Log::make_step_log(const Instance& ins, const std::string& output_name,
+void Log::make_step_log(const Instance& ins, const std::vector<int>& distances, const std::string& output_name,
   const double comp_time_ms, const std::string& map_name,
   const int seed, const bool log_short)
 {
   // map name
   std::smatch results;
-  const auto map_recorded_name =
+  StepRecord record;
+  record.map_name =
     (std::regex_match(map_name, results, r_map_name)) ? results[1].str()
     : map_name;
 
-  // for instance-specific values
-  auto dist_table = DistTable(ins);
+  record.agents = ins.parser->num_agents;
+  record.solved = !step_solution.empty();
+  record.soc = get_sum_of_costs();
+  record.soc_lb = get_sum_of_costs_lower_bound(distances);
+  record.makespan = get_makespan();
+  record.makespan_lb = get_makespan_lower_bound(distances);
+  record.sum_of_loss = get_sum_of_loss();
+  record.comp_time_ms = comp_time_ms;
+  record.seed = seed;
+  record.log_short = log_short;
+  record.width = ins.graph.width;
+
+  if (!log_short) {
+    for (auto v : ins.starts) record.starts.push_back(v->index);
+    for (auto v : ins.goals) record.goals.push_back(v->index);
+    record.solution.reserve(step_solution.size() * record.agents);
+    for (auto& C : step_solution) {
+      for (auto v : C) record.solution.push_back(v->index);
+    }
+  }
+
+  // Wait for the writer when the buffer is full
+  while (!step_records.push(record)) std::this_thread::yield();
+  _notify_step_writer();
+}
 
+void Log::_notify_step_writer()
+{
+  // Writer only waits after draining the buffer, so it is woken once per
+  // empty to non-empty change. The fence pairs with the writer's, either
+  // the writer sees the record or this sees the writer waiting.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!step_writer_waiting.load(std::memory_order_relaxed)) return;
+  std::lock_guard<std::mutex> lock(step_writer_mutex);
+  step_writer_cv.notify_one();
+}
+
+void Log::_write_steps()
+{
+  StepRecord record;
+  while (true) {
+    if (step_records.pop(record)) {
+      _write_step_record(record);
+      continue;
+    }
+    // All records are pushed before done is set, drain them and stop
+    if (step_writer_done.load(std::memory_order_acquire)) {
+      while (step_records.pop(record)) _write_step_record(record);
+      break;
+    }
+    // Sleep until a record is pushed or the log is closed
+    std::unique_lock<std::mutex> lock(step_writer_mutex);
+    step_writer_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    step_writer_cv.wait(lock, [&] { return !step_records.empty() || step_writer_done.load(std::memory_order_acquire); });
+    step_writer_waiting.store(false, std::memory_order_relaxed);
+  }
+}
+
+void Log::_write_step_record(const StepRecord& record)
+{
   // log for visualizer
-  auto get_x = [&](int k) { return k % ins.graph.width; };
-  auto get_y = [&](int k) { return k / ins.graph.width; };
-
-  step_output_handler << "agents=" << ins.parser->num_agents << std::endl
-    << "map_file=" << map_recorded_name << std::endl
-    << "solver=planner" << std::endl
-    << "solved=" << !step_solution.empty() << std::endl
-    << "soc=" << get_sum_of_costs() << std::endl
-    << "soc_lb=" << get_sum_of_costs_lower_bound(ins, dist_table) << std::endl
-    << "makespan=" << get_makespan() << std::endl
-    << "makespan_lb=" << get_makespan_lower_bound(ins, dist_table) << std::endl
-    << "sum_of_loss=" << get_sum_of_loss() << std::endl
-    << "sum_of_loss_lb=" << get_sum_of_costs_lower_bound(ins, dist_table) << std::endl
-    << "comp_time=" << comp_time_ms << std::endl
-    << "seed=" << seed << std::endl;
-
-  if (log_short) return;
+  auto get_x = [&](int k) { return k % record.width; };
+  auto get_y = [&](int k) { return k / record.width; };
+
+  step_output_handler << "agents=" << record.agents << '\n'
+    << "map_file=" << record.map_name << '\n'
+    << "solver=planner" << '\n'
+    << "solved=" << record.solved << '\n'
+    << "soc=" << record.soc << '\n'
+    << "soc_lb=" << record.soc_lb << '\n'
+    << "makespan=" << record.makespan << '\n'
+    << "makespan_lb=" << record.makespan_lb << '\n'
+    << "sum_of_loss=" << record.sum_of_loss << '\n'
+    << "sum_of_loss_lb=" << record.soc_lb << '\n'
+    << "comp_time=" << record.comp_time_ms << '\n'
+    << "seed=" << record.seed << '\n';
+
+  if (record.log_short) return;
   step_output_handler << "starts=";
-  for (size_t i = 0; i < ins.parser->num_agents; ++i) {
-    auto k = ins.starts[i]->index;
-    step_output_handler << "(" << get_x(k) << "," << get_y(k) << "),";
-  }
-  step_output_handler << std::endl << "goals=";
-  for (size_t i = 0; i < ins.parser->num_agents; ++i) {
-    auto k = ins.goals[i]->index;
-    step_output_handler << "(" << get_x(k) << "," << get_y(k) << "),";
-  }
-  step_output_handler << std::endl << "solution=" << std::endl;
+  for (auto k : record.starts) step_output_handler << "(" << get_x(k) << "," << get_y(k) << "),";
+  step_output_handler << '\n' << "goals=";
+  for (auto k : record.goals) step_output_handler << "(" << get_x(k) << "," << get_y(k) << "),";
+  step_output_handler << '\n' << "solution=" << '\n';
 
-  std::vector<std::vector<int> > new_sol(ins.parser->num_agents, std::vector<int>(step_solution.size(), 0));
-  for (size_t t = 0; t < step_solution.size(); ++t) {
+  const size_t T = record.agents == 0 ? 0 : record.solution.size() / record.agents;
+  for (size_t t = 0; t < T; ++t) {
     step_output_handler << t << ":";
-    auto C = step_solution[t];
-    int idx = 0;
-    for (auto v : C) {
-      step_output_handler << "(" << get_x(v->index) << "," << get_y(v->index) << "),";
-      new_sol[idx][t] = v->index;
-      idx++;
+    for (size_t i = 0; i < record.agents; ++i) {
+      auto k = record.solution[t * record.agents + i];
+      step_output_handler << "(" << get_x(k) << "," << get_y(k) << "),";
     }
-    step_output_handler << std::endl;
+    step_output_handler << '\n';
   }
 }
 
-void Log::make_life_long_log(const Instance& ins, std::string visual_name)
+void Log::make_life_long_log(const Instance& ins)
 {
-  log_console->info("life long solution size: {}, bit status size: {}", life_long_solution.size(), bit_status_log.size());
-
-  auto dist_table = DistTable(ins);
-  auto get_x = [&](int k) { return k % ins.graph.width; };
-  auto get_y = [&](int k) { return k / ins.graph.width; };
-  std::vector<std::vector<int> > new_sol(ins.parser->num_agents, std::vector<int>(life_long_solution.size(), 0));
-
-  for (size_t t = 0; t < life_long_solution.size(); ++t) {
-    auto C = life_long_solution[t];
-    int idx = 0;
-    for (auto v : C) {
-      new_sol[idx][t] = v->index;
-      idx++;
-    }
+  // Write the last partial chunk, the visual file is made from the spill file
+  if (chunk_steps > 0 || !trajectory_spill.is_open()) _spill_trajectory_chunk();
+  trajectory_spill.close();
+  log_console->info("life long solution size: {}, spilled chunks: {}", trajectory_steps, spilled_chunks);
+
+  if (!write_trajectory_yaml(trajectory_spill_file, visual_output_handler, ins.graph.width, ins.graph.height)) {
+    log_console->error("Failed to read file: {}", trajectory_spill_file);
+    return;
   }
+  visual_output_handler.flush();
+
+  // Remove spill file
+  std::remove(trajectory_spill_file.c_str());
+}
 
-  visual_output_handler << "width: " << ins.graph.width << std::endl
-    << "height: " << ins.graph.height << std::endl
-    << "schedule: " << std::endl;
-
-  for (size_t a = 0; a < new_sol.size(); ++a) {
-    visual_output_handler << "  agent" << a << ":" << std::endl;
-    for (size_t t = 0; t < new_sol[a].size(); ++t) {
-      visual_output_handler << "    - x: " << get_y(new_sol[a][t]) << std::endl
-        << "      y: " << get_x(new_sol[a][t]) << std::endl
-        << "      t: " << t << std::endl
-        << "      s: " << bit_status_log[t][a] << std::endl;
+bool write_trajectory_yaml(const std::string& spill_file, std::ostream& output, int width, int height)
+{
+  std::ifstream spill(spill_file, std::ios::binary);
+  TrajectorySpillHeader header;
+  if (!spill.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+  if (std::memcmp(header.magic, TRAJECTORY_SPILL_MAGIC, 4) != 0 || header.version != TRAJECTORY_SPILL_VERSION || header.chunk_size == 0) return false;
+
+  auto get_x = [&](int k) { return k % width; };
+  auto get_y = [&](int k) { return k / width; };
+
+  output << "width: " << width << '\n'
+    << "height: " << height << '\n'
+    << "schedule: " << '\n';
+
+  // Trajectory of each agent, one run of entries from every chunk
+  const size_t chunks = (header.steps + header.chunk_size - 1) / header.chunk_size;
+  const size_t chunk_bytes = header.chunk_size * sizeof(TrajectoryEntry);
+  std::vector<TrajectoryEntry> entries(header.chunk_size);
+  for (size_t a = 0; a < header.agents; ++a) {
+    output << "  agent" << a << ":" << '\n';
+    uint64_t t = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+      spill.seekg(sizeof(header) + (c * header.agents + a) * chunk_bytes);
+      if (!spill.read(reinterpret_cast<char*>(entries.data()), chunk_bytes)) return false;
+      for (size_t k = 0; k < header.chunk_size && t < header.steps; ++k, ++t) {
+        output << "    - x: " << get_y(entries[k].index) << '\n'
+          << "      y: " << get_x(entries[k].index) << '\n'
+          << "      t: " << t << '\n'
+          << "      s: " << entries[k].status << '\n';
+      }
     }
   }
+  return true;
 }
 
 void Log::make_throughput_log(uint index, uint* start_cnt, uint make_span)
@@ -307,9 +448,9 @@ void Log::make_throughput_log(uint index, uint* start_cnt, uint make_span)
 void Log::make_csv_log(double cache_hit_rate, uint make_span, std::vector<uint>* step_percentiles, uint ngoals, int64_t elapsed_time, bool failure)
 {
   if (!failure) {
-    csv_output_handler << cache_hit_rate << "," << make_span << "," << (double)ngoals / (double)make_span << "," << (*step_percentiles)[0] << "," << (*step_percentiles)[2] << "," << (*step_percentiles)[6] << "," << elapsed_time << std::endl;
+    csv_output_handler << cache_hit_rate << "," << make_span << "," << (double)ngoals / (double)make_span << "," << (*step_percentiles)[0] << "," << (*step_percentiles)[2] << "," << (*step_percentiles)[6] << "," << elapsed_time << '\n';
   }
   else {
-    csv_output_handler << "fail to solve" << std::endl;
+    csv_output_handler << "fail to solve" << '\n';
   }
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+// Look ahead goals queue implementation
+// Author: Zhenghong Yu
+
+#include "../include/look_ahead.hpp"
+
+void LookAheadQueue::push_back(Vertex* goal) {
+    goals.push_back(goal);
+    delay_diff.push_back(0);
+    num_goals++;
+}
+
+void LookAheadQueue::clear() {
+    *this = LookAheadQueue();
+}
+
+uint LookAheadQueue::size() const {
+    return num_goals;
+}
+
+bool LookAheadQueue::empty() const {
+    return num_goals == 0;
+}
+
+Vertex* LookAheadQueue::front() const {
+    return goals.front();
+}
+
+int LookAheadQueue::get_delay(uint index) const {
+    int delay = front_delay;
+    for (uint i = 0; i < index; i++) delay -= delay_diff[i];
+    return delay;
+}
+
+void LookAheadQueue::update_cached(Vertex* cargo, bool is_cached) {
+    auto it = window_seq.find(cargo);
+    if (it == window_seq.end()) return;
+    for (uint64_t seq : it->second) {
+        if (is_cached) cached.insert(seq);
+        else cached.erase(seq);
+    }
+}
+
+void LookAheadQueue::extend_window(uint look_ahead, Cache* cache) {
+    // Goals behind the window are never taken
+    while (window_size < look_ahead && window_end < goals.size()) {
+        Vertex* goal = goals[window_end];
+        uint64_t seq = head_seq + window_end;
+        window_seq[goal].push_back(seq);
+        if (cache != nullptr && cache->look_ahead_cache(goal)) cached.insert(seq);
+        window_end++;
+        window_size++;
+    }
+}
+
+Vertex* LookAheadQueue::take(uint index) {
+    // Goals before it are passed over
+    if (index > 0) {
+        delay_diff[index - 1]++;
+        front_delay++;
+    }
+    return _take(index);
+}
+
+Vertex* LookAheadQueue::pop(uint look_ahead, int delay_limit, Cache* cache) {
+    if (num_goals == 0) return nullptr;
+    extend_window(look_ahead, cache);
+
+    // Front goal reaches the delay limit, take it directly
+    if (cache != nullptr && front_delay >= delay_limit) return _take(0);
+
+    // Take the first cached goal
+    if (!cached.empty()) return take(*cached.begin() - head_seq);
+
+    // No cached goal, take the front goal and pass over the rest of window
+    delay_diff[window_end - 1]++;
+    front_delay++;
+    return _take(0);
+}
+
+Vertex* LookAheadQueue::_take(uint index) {
+    Vertex* goal = goals[index];
+    uint64_t seq = head_seq + index;
+    auto& seqs = window_seq[goal];
+    seqs.erase(std::find(seqs.begin(), seqs.end(), seq));
+    if (seqs.empty()) window_seq.erase(goal);
+    cached.erase(seq);
+    goals[index] = nullptr;
+    window_size--;
+    num_goals--;
+
+    // Drop taken goals at the front
+    while (!goals.empty() && goals.front() == nullptr) {
+        front_delay -= delay_diff.front();
+        goals.pop_front();
+        delay_diff.pop_front();
+        head_seq++;
+        window_end--;
+    }
+    return goal;
+}
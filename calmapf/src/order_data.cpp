@@ -0,0 +1,205 @@
+// Real order data loader implementation
+// Author: Zhenghong Yu
+
+#include "../include/order_data.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char ORDER_DATA_MAGIC[4] = { 'C', 'A', 'L', 'F' };
+static const uint32_t ORDER_DATA_VERSION = 2;
+
+uint64_t hash_order_data(const char* data, size_t size) {
+    // FNV-1a over 64-bit words, tail bytes one by one
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    for (; i < size; i++) hash = (hash ^ uint8_t(data[i])) * 0x100000001b3ULL;
+    return hash ^ size;
+}
+
+// Parse the product id of the line at p and move p to the next line
+static bool _parse_product_id(const char*& p, const char* end, uint64_t& product_id, bool& negative) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    negative = p < end && *p == '-';
+    if (negative) p++;
+
+    product_id = 0;
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9') product_id = product_id * 10 + (*p++ - '0');
+    bool valid = p != digits;
+
+    const char* next = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    p = next == nullptr ? end : next + 1;
+    return valid;
+}
+
+// Offset of the first order line, after the header row
+static size_t _get_first_order_offset(const char* data, size_t size) {
+    const char* p = static_cast<const char*>(std::memchr(data, '\n', size));
+    return p == nullptr ? size : p - data + 1;
+}
+
+std::vector<uint64_t> parse_order_data(const char* data, size_t size, uint64_t& total) {
+    // Product ids of real exports are sparse, count by id and compact after
+    std::unordered_map<uint64_t, uint64_t> id_count;
+    total = 0;
+
+    const char* end = data + size;
+    const char* p = data + _get_first_order_offset(data, size);
+    uint64_t product_id;
+    bool negative;
+    while (p < end) {
+        // Rows without a product id (e.g. blank lines) are skipped,
+        // negative ids are counted as orders but have no frequency
+        if (!_parse_product_id(p, end, product_id, negative)) continue;
+        total++;
+        if (negative) continue;
+        id_count[product_id]++;
+    }
+
+    // Dense histogram in ascending product id order
+    std::vector<std::pair<uint64_t, uint64_t>> sorted(id_count.begin(), id_count.end());
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<uint64_t> count;
+    count.reserve(sorted.size());
+    for (auto& product : sorted) count.push_back(product.second);
+    return count;
+}
+
+static bool load_order_data_sidecar(const std::string& sidecar_path, uint64_t file_hash, uint64_t file_size, std::vector<float>& prob_v) {
+    std::ifstream sidecar(sidecar_path, std::ios::binary);
+    if (!sidecar) return false;
+
+    OrderDataHeader header;
+    if (!sidecar.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, ORDER_DATA_MAGIC, 4) != 0 || header.version != ORDER_DATA_VERSION) return false;
+    if (header.file_hash != file_hash || header.file_size != file_size) return false;
+
+    prob_v.resize(header.num_products);
+    return bool(sidecar.read(reinterpret_cast<char*>(prob_v.data()), prob_v.size() * sizeof(float)));
+}
+
+static void save_order_data_sidecar(const std::string& sidecar_path, uint64_t file_hash, uint64_t file_size, const std::vector<float>& prob_v) {
+    // Write to a temporary file first so concurrent runs never read a partial sidecar
+    std::string tmp_path = sidecar_path + "." + std::to_string(getpid());
+    std::ofstream sidecar(tmp_path, std::ios::binary);
+    if (!sidecar) return;
+
+    OrderDataHeader header;
+    std::memcpy(header.magic, ORDER_DATA_MAGIC, 4);
+    header.version = ORDER_DATA_VERSION;
+    header.file_hash = file_hash;
+    header.file_size = file_size;
+    header.num_products = prob_v.size();
+    sidecar.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    sidecar.write(reinterpret_cast<const char*>(prob_v.data()), prob_v.size() * sizeof(float));
+    sidecar.close();
+
+    if (!sidecar || std::rename(tmp_path.c_str(), sidecar_path.c_str()) != 0) std::remove(tmp_path.c_str());
+}
+
+// This is a general function that loads teh data file and compute the frequency of each product.
+// The frequencies will be used to generate a sequence of products.
+// The probability vector: prob_v[k] = frequency of the k-th smallest product id in the data.
+std::vector<float> compute_frequency_from_file(std::string file_path) {
+    std::vector<float> prob_v;
+
+    int fd = open(file_path.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0) {
+        if (fd >= 0) close(fd);
+        std::cerr << "Failed to open data file." << std::endl;
+        return prob_v;
+    }
+
+    // Files loaded in this process, keyed by path, size and modification time
+    static std::unordered_map<std::string, std::vector<float>> loaded;
+    std::string key = file_path + ":" + std::to_string(file_stat.st_size) + ":" + std::to_string(file_stat.st_mtime);
+    if (auto it = loaded.find(key); it != loaded.end()) {
+        close(fd);
+        return it->second;
+    }
+
+    uint64_t file_size = file_stat.st_size;
+    const char* data = nullptr;
+    if (file_size > 0) {
+        void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            std::cerr << "Failed to map data file." << std::endl;
+            return prob_v;
+        }
+        madvise(mapped, file_size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    close(fd);
+
+    uint64_t file_hash = hash_order_data(data, file_size);
+    std::string sidecar_path = file_path + ".freq";
+    if (!load_order_data_sidecar(sidecar_path, file_hash, file_size, prob_v)) {
+        uint64_t total = 0;
+        std::vector<uint64_t> count = parse_order_data(data, file_size, total);
+        prob_v.assign(count.size(), 0.0f);
+        for (uint i = 0; i < count.size(); i++) prob_v[i] = static_cast<float>(count[i]) / total;
+        save_order_data_sidecar(sidecar_path, file_hash, file_size, prob_v);
+    }
+
+    if (data != nullptr) munmap(const_cast<char*>(data), file_size);
+    loaded[key] = prob_v;
+    return prob_v;
+}
+
+OrderStream::OrderStream(const std::string& file_path) {
+    int fd = open(file_path.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    void* mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return;
+    madvise(mapped, file_stat.st_size, MADV_SEQUENTIAL);
+
+    data = static_cast<const char*>(mapped);
+    size = file_stat.st_size;
+    first = _get_first_order_offset(data, size);
+    cursor = first;
+}
+
+OrderStream::~OrderStream() {
+    if (data != nullptr) munmap(const_cast<char*>(data), size);
+}
+
+bool OrderStream::is_open() const {
+    return data != nullptr;
+}
+
+bool OrderStream::next(uint64_t& product_id) {
+    if (data == nullptr) return false;
+
+    const char* end = data + size;
+    bool rewound = false;
+    bool negative;
+    while (true) {
+        if (cursor >= size) {
+            // A second rewind without any order means the file has none
+            if (rewound) return false;
+            rewound = true;
+            rewind_cnt++;
+            cursor = first;
+        }
+        const char* p = data + cursor;
+        bool valid = _parse_product_id(p, end, product_id, negative);
+        cursor = p - data;
+        if (valid && !negative) return true;
+    }
+}
@@ -12,17 +12,28 @@ Parser::Parser(int argc, char* argv[]) {
     // arguments definition
     argparse::ArgumentParser program("CAL-MAPF", "0.1.0");
     program.add_argument("-mf", "--map-file").help("Path to the map file.").required();
-    program.add_argument("-ct", "--cache-type").help("Type of cache to use: NONE, LRU, FIFO, RANDOM. Defaults to NONE.").default_value(std::string("NONE"));
+    program.add_argument("-ct", "--cache-type").help("Type of cache to use: NONE, LRU, FIFO, RANDOM, LFU, ARC, TINYLFU, ADAPTIVE. Defaults to NONE.").default_value(std::string("NONE"));
+    program.add_argument("-ae", "--adaptive-epoch").help("Number of cargo requests per epoch to compare shadow caches of adaptive cache. Defaults to 200.").default_value(std::string("200"));
     program.add_argument("-lan", "--look-ahead-num").help("Number for look-ahead logic. Defaults to 1.").default_value(std::string("1"));
     program.add_argument("-ddl", "--delay-deadline-limit").help("Delay deadline limit for task assignment. Defaults to 1.").default_value(std::string("1"));
+    program.add_argument("-ba", "--batch-assignment").help("Assign agents freed in the same step together, matching them to goals of their group by minimum total travel distance. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-cas", "--cost-aware-selection").help("Pick the look-ahead goal with the cheapest trip from the agent, counting cache status and delay. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-ap", "--any-port").help("Deliver cargo to any unloading port, chosen by distance and agents heading to it, agents join the group of the port. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-rc", "--request-coalescing").help("Agents requesting cargo that is coming into cache wait for it at its cache block instead of fetching it from warehouse. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-dac", "--distance-aware-cache").help("Enable distance-aware cache block selection for insertion and eviction. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-sc", "--shared-cache").help("Share cache blocks across groups, quota of each group is rebalanced by its misses. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-gr", "--garbage-relocation").help("Drop evicted cargo at the nearest free shelf ('E' in map) instead of its original shelf. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-si", "--slotting-interval").help("Assign a slotting task moving hot cargo closer to unloading port after every N cargo requests, and to idle agents. 0 disables slotting. Defaults to 0.").default_value(std::string("0"));
+    program.add_argument("-pfw", "--prefetch-window").help("Number of upcoming goals scanned to prefetch hot cargo by idle agents, 0 disables prefetching. Defaults to 0.").default_value(std::string("0"));
     program.add_argument("-ng", "--num-goals").help("Number of goals to achieve.").required();
-    program.add_argument("-ggs", "--goals-gen-strategy").help("Strategy for goals generation: MK, Zhang, Real, Hybrid.").required();
+    program.add_argument("-ggs", "--goals-gen-strategy").help("Strategy for goals generation: MK, Zhang, Real, Hybrid, Replay.").required();
     program.add_argument("-gmk", "--goals-max-k").help("Maximum 'k' different goals in 'm' segments of all goals. Defaults to 0.").default_value(std::string("0"));
     program.add_argument("-gmm", "--goals-max-m").help("Maximum 'k' different goals in 'm' segments of all goals. Defaults to 100.").default_value(std::string("100"));
     program.add_argument("-rdfp", "--real-dist-file-path").help("Path to the real distribution data file. Defaults to './data/order_data.csv'.").default_value(std::string("./data/order_data.csv"));
     program.add_argument("-hp", "--hybrid-percent").help("The percentage that a certain number of distribution goals appear (e.g. \"90:5:5\"). If not set, every strategy has the same percentage").default_value(std::string("1:1:1"));
     program.add_argument("-na", "--num-agents").help("Number of agents to use.").required();
     program.add_argument("-ac", "--agent-capacity").help("Capacity of agents.").default_value(std::string("100"));
+    program.add_argument("-tc", "--trip-capacity").help("Maximum number of cargo an agent picks in one trip before going back to unloading port. Defaults to 1.").default_value(std::string("1"));
     program.add_argument("-rs", "--random-seed").help("Seed for random number generation. Defaults to 0.").default_value(std::string("0"));
     program.add_argument("-tls", "--time-limit-sec").help("Time limit in seconds. Defaults to 10.").default_value(std::string("10"));
     program.add_argument("-osrf", "--output-step-file").help("Path to the step result output file. Defaults to './result/step_result.txt'.").default_value(std::string("./result/step_result.txt"));
@@ -31,6 +42,8 @@ Parser::Parser(int argc, char* argv[]) {
     program.add_argument("-vof", "--visual-output-file").help("Path to the visual output file. Defaults to './result/vis.yaml'.").default_value(std::string("./result/vis.yaml"));
     program.add_argument("-slf", "--short-log-format").help("Enable short log format. Implicitly true when set.").default_value(false).implicit_value(true);
     program.add_argument("-dl", "--debug-log").help("Enable debug logging. Implicitly true when set.").default_value(false).implicit_value(true);
+    program.add_argument("-fci", "--feasibility-check-interval").help("Check feasibility of the solution of every N planning steps, 0 disables the check. Defaults to 1.").default_value(std::string("1"));
+    program.add_argument("-afc", "--async-feasibility-check").help("Check conflicts of solutions on a background thread, a failure is reported at the next check. Implicitly true when set.").default_value(false).implicit_value(true);
     program.add_argument("-op", "--optimize").help("Enable optimization. Enable checking empty space for cache insert while moving.").default_value(false).implicit_value(true);
 
     try {
@@ -46,6 +59,16 @@ Parser::Parser(int argc, char* argv[]) {
     cache_type_input = program.get<std::string>("cache-type");
     look_ahead_num = std::stoi(program.get<std::string>("look-ahead-num"));
     delay_deadline_limit = std::stoi(program.get<std::string>("delay-deadline-limit"));
+    distance_aware_cache = program.get<bool>("distance-aware-cache");
+    shared_cache = program.get<bool>("shared-cache");
+    garbage_relocation = program.get<bool>("garbage-relocation");
+    cost_aware_selection = program.get<bool>("cost-aware-selection");
+    batch_assignment = program.get<bool>("batch-assignment");
+    request_coalescing = program.get<bool>("request-coalescing");
+    any_port = program.get<bool>("any-port");
+    prefetch_window = std::stoi(program.get<std::string>("prefetch-window"));
+    slotting_interval = std::stoi(program.get<std::string>("slotting-interval"));
+    adaptive_epoch = std::stoi(program.get<std::string>("adaptive-epoch"));
 
     num_goals = std::stoi(program.get<std::string>("num-goals"));
     goals_gen_strategy_input = program.get<std::string>("goals-gen-strategy");
@@ -56,6 +79,7 @@ Parser::Parser(int argc, char* argv[]) {
 
     num_agents = std::stoi(program.get<std::string>("num-agents"));
     agent_capacity = std::stoi(program.get<std::string>("agent-capacity"));
+    trip_capacity = std::stoi(program.get<std::string>("trip-capacity"));
 
     random_seed = std::stoi(program.get<std::string>("random-seed"));
     time_limit_sec = std::stoi(program.get<std::string>("time-limit-sec"));
@@ -67,6 +91,8 @@ Parser::Parser(int argc, char* argv[]) {
 
     short_log_format = program.get<bool>("short-log-format");
     debug_log = program.get<bool>("debug-log");
+    feasibility_check_interval = std::stoi(program.get<std::string>("feasibility-check-interval"));
+    async_feasibility_check = program.get<bool>("async-feasibility-check");
 
     // Post parse
     _post_parse();
@@ -95,6 +121,18 @@ void Parser::_post_parse() {
     else if (cache_type_input == "RANDOM") {
         cache_type = CacheType::RANDOM;
     }
+    else if (cache_type_input == "LFU") {
+        cache_type = CacheType::LFU;
+    }
+    else if (cache_type_input == "ARC") {
+        cache_type = CacheType::ARC;
+    }
+    else if (cache_type_input == "TINYLFU") {
+        cache_type = CacheType::TINYLFU;
+    }
+    else if (cache_type_input == "ADAPTIVE") {
+        cache_type = CacheType::ADAPTIVE;
+    }
     else {
         parser_console->error("Invalid cache type!");
         exit(1);
@@ -123,6 +161,13 @@ void Parser::_post_parse() {
         strategy_num_goals.push_back(0);
         strategy_num_goals.push_back(num_goals);
     }
+    else if (goals_gen_strategy_input == "Replay") {
+        // Goals are streamed from the order data file, not generated
+        goals_gen_strategy = GoalGenerationType::Replay;
+        strategy_num_goals.push_back(0);
+        strategy_num_goals.push_back(0);
+        strategy_num_goals.push_back(0);
+    }
     else if (goals_gen_strategy_input == "Hybrid") {
         goals_gen_strategy = GoalGenerationType::Hybrid;
         std::vector<int> percentages;
@@ -155,14 +200,45 @@ void Parser::_check() {
         parser_console->error("look ahead should be greater than 1");
         exit(1);
     }
+    if (prefetch_window < 0) {
+        parser_console->error("prefetch window should not be negative");
+        exit(1);
+    }
+    if (slotting_interval < 0) {
+        parser_console->error("slotting interval should not be negative");
+        exit(1);
+    }
+    if (adaptive_epoch < 1) {
+        parser_console->error("adaptive epoch should be greater than 0");
+        exit(1);
+    }
+    if (trip_capacity < 1) {
+        parser_console->error("trip capacity should be greater than 0");
+        exit(1);
+    }
+    if (feasibility_check_interval < 0) {
+        parser_console->error("feasibility check interval should not be negative");
+        exit(1);
+    }
 }
 
 void Parser::_print() {
     parser_console->info("Map file:         {}", map_file);
     parser_console->info("Cache type:       {}", cache_type_input);
     parser_console->info("Look ahead:       {}", look_ahead_num);
+    parser_console->info("Distance aware:   {}", distance_aware_cache);
+    parser_console->info("Shared cache:     {}", shared_cache);
+    parser_console->info("Relocation:       {}", garbage_relocation);
+    parser_console->info("Cost aware:       {}", cost_aware_selection);
+    parser_console->info("Batch assignment: {}", batch_assignment);
+    parser_console->info("Coalescing:       {}", request_coalescing);
+    parser_console->info("Any port:         {}", any_port);
+    parser_console->info("Prefetch window:  {}", prefetch_window);
+    parser_console->info("Slotting:         {}", slotting_interval);
+    if (cache_type == CacheType::ADAPTIVE) parser_console->info("Adaptive epoch:   {}", adaptive_epoch);
     parser_console->info("Number of goals:  {}", num_goals);
     parser_console->info("Number of agents: {}", num_agents);
+    parser_console->info("Trip capacity:    {}", trip_capacity);
     parser_console->info("Goal Generation:  {}", goals_gen_strategy_input);
     if (goals_gen_strategy == GoalGenerationType::MK) {
         parser_console->info("Goals m:          {}", goals_max_m);
@@ -180,6 +256,8 @@ void Parser::_print() {
     parser_console->info("Visual file:      {}", output_visual_file);
     parser_console->info("Log short:        {}", short_log_format);
     parser_console->info("Debug:            {}", debug_log);
+    parser_console->info("Check interval:   {}", feasibility_check_interval);
+    parser_console->info("Async check:      {}", async_feasibility_check);
 }
 
 // Unit test only
@@ -198,8 +276,23 @@ Parser::Parser(
 
     look_ahead_num = 1;
     delay_deadline_limit = 10;
+    distance_aware_cache = false;
+    shared_cache = false;
+    garbage_relocation = false;
+    cost_aware_selection = false;
+    batch_assignment = false;
+    request_coalescing = false;
+    any_port = false;
+    prefetch_window = 0;
+    slotting_interval = 0;
+    adaptive_epoch = 200;
 
     num_goals = 100;
+    agent_capacity = 100;
+    trip_capacity = 1;
+    debug_log = false;
+    feasibility_check_interval = 1;
+    async_feasibility_check = false;
 
     goals_gen_strategy = GoalGenerationType::MK;
     strategy_num_goals.push_back(100);
@@ -95,7 +95,8 @@ Solution Planner::solve()
     S = OPEN.top();
 
     // check goal condition
-    if (is_reach_at_least_one(S->C, ins->goals)) {
+    if (ins->is_goal_reached(S->C)) {
+      reached = ins->get_reached_agents(S->C);
       // backtrack
       while (S != nullptr) {
         solution.push_back(S->C);
@@ -253,9 +254,16 @@ bool Planner::funcPIBT(Agent* ai)
 }
 
 Solution solve(const Instance& ins, const Deadline* deadline,
-  std::mt19937* MT)
+  std::mt19937* MT, std::vector<size_t>* reached, std::vector<int>* distances)
 {
   // info(1, verbose, "elapsed:", elapsed_ms(deadline), "ms\tpre-processing");
   auto planner = Planner(&ins, deadline, MT);
-  return planner.solve();
+  auto solution = planner.solve();
+  if (reached != nullptr) *reached = std::move(planner.reached);
+  // Evaluated by the planner for the initial node already
+  if (distances != nullptr) {
+    distances->resize(planner.N);
+    for (auto i = 0; i < planner.N; ++i) (*distances)[i] = planner.D.get(i, ins.starts[i]);
+  }
+  return solution;
 }
@@ -0,0 +1,141 @@
+// Goal sampler implementation
+// Author: Zhenghong Yu
+
+#include "../include/sampler.hpp"
+
+AliasSampler::AliasSampler(const std::vector<double>& weights) {
+    uint n = weights.size();
+    prob.assign(n, 1.0);
+    threshold.assign(n, UINT32_MAX);
+    alias.resize(n);
+    std::iota(alias.begin(), alias.end(), 0);
+
+    double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+    // All zero weights fall back to uniform sampling
+    if (n == 0 || total <= 0) return;
+
+    // Scale weights so the average column is 1, then pair every small
+    // column with a large one (Vose)
+    std::vector<double> scaled(n);
+    std::vector<uint> small, large;
+    for (uint i = 0; i < n; i++) {
+        scaled[i] = weights[i] * n / total;
+        if (scaled[i] < 1.0) small.push_back(i);
+        else large.push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        uint s = small.back();
+        uint l = large.back();
+        small.pop_back();
+        prob[s] = scaled[s];
+        alias[s] = l;
+        scaled[l] = scaled[l] + scaled[s] - 1.0;
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Remaining columns are full, up to rounding errors
+    for (uint i : large) prob[i] = 1.0;
+    for (uint i : small) prob[i] = 1.0;
+
+    // Full columns never take the alias
+    for (uint i = 0; i < n; i++) {
+        if (prob[i] >= 1.0) alias[i] = i;
+        threshold[i] = prob[i] >= 1.0 ? UINT32_MAX : uint32_t(prob[i] * 4294967296.0);
+    }
+}
+
+uint AliasSampler::sample(std::mt19937* MT) const {
+    // Multiply-shift maps a 32-bit draw to a column, bias is n / 2^32
+    uint column = (uint64_t((*MT)()) * prob.size()) >> 32;
+    return (*MT)() < threshold[column] ? column : alias[column];
+}
+
+bool IndexedVertexSet::contains(Vertex* v) const {
+    return position.count(v) > 0;
+}
+
+bool IndexedVertexSet::insert(Vertex* v) {
+    if (contains(v)) return false;
+    position[v] = items.size();
+    items.push_back(v);
+    return true;
+}
+
+bool IndexedVertexSet::erase(Vertex* v) {
+    auto it = position.find(v);
+    if (it == position.end()) return false;
+
+    // Move the last element into the hole
+    uint index = it->second;
+    Vertex* last = items.back();
+    items[index] = last;
+    position[last] = index;
+    items.pop_back();
+    position.erase(v);
+    return true;
+}
+
+uint IndexedVertexSet::size() const {
+    return items.size();
+}
+
+Vertex* IndexedVertexSet::at(uint index) const {
+    return items[index];
+}
+
+GoalGenerator::GoalGenerator(const Vertices* _candidates, std::mt19937* _MT, const std::vector<uint>& _remaining,
+    uint _max_k, uint _max_m, const std::vector<double>& zhang_weights, const std::vector<double>& real_weights)
+    : candidates(_candidates), MT(_MT), remaining(_remaining), max_k(_max_k), max_m(_max_m),
+    zhang_sampler(zhang_weights), real_sampler(real_weights) {
+    assert(remaining.size() == 3);
+}
+
+uint GoalGenerator::size() const {
+    return std::accumulate(remaining.begin(), remaining.end(), 0u);
+}
+
+Vertex* GoalGenerator::next() {
+    if (!remaining.empty() && remaining[0] > 0) {
+        remaining[0]--;
+        return _next_mk_goal();
+    }
+    if (remaining.size() > 1 && remaining[1] > 0) {
+        remaining[1]--;
+        return (*candidates)[zhang_sampler.sample(MT)];
+    }
+    if (remaining.size() > 2 && remaining[2] > 0) {
+        remaining[2]--;
+        return (*candidates)[real_sampler.sample(MT)];
+    }
+    return nullptr;
+}
+
+Vertex* GoalGenerator::_next_mk_goal() {
+    assert(!candidates->empty());
+    Vertex* selected_goal = (*candidates)[get_random_int(MT, 0, candidates->size() - 1)];
+
+    if (sliding_window.size() == max_m) {
+        Vertex* removed_goal = sliding_window.front();
+        sliding_window.pop_front();
+        goal_count[removed_goal]--;
+        if (goal_count[removed_goal] == 0) {
+            goal_count.erase(removed_goal);
+            diff_goals.erase(removed_goal);
+        }
+    }
+
+    if (diff_goals.size() == max_k) {
+        int index = get_random_int(MT, 0, max_k - 1);
+        selected_goal = diff_goals.at(index);
+    }
+
+    // Update status
+    sliding_window.push_back(selected_goal);
+    goal_count[selected_goal]++;
+    diff_goals.insert(selected_goal);
+    return selected_goal;
+}
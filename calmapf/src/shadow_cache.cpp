@@ -0,0 +1,103 @@
+// Shadow cache implementation
+// Author: Zhenghong Yu
+
+#include "../include/shadow_cache.hpp"
+
+ShadowCache::ShadowCache(CacheType _cache_type, uint _capacity, uint cargo_num) :
+    cache_type(_cache_type), capacity(_capacity), sketch(cargo_num) {}
+
+int ShadowCache::_get_evicted_index() {
+    int min_index = -1;
+    int t1_min_index = -1;
+    uint t1_size = 0;
+
+    for (uint i = 0; i < cargo.size(); i++) {
+        if (cache_type == CacheType::ARC && !frequent[i]) {
+            t1_size++;
+            if (t1_min_index == -1 || stamp[i] < stamp[t1_min_index]) t1_min_index = i;
+        }
+        else if (min_index == -1 || stamp[i] < stamp[min_index]) {
+            min_index = i;
+        }
+    }
+
+    // ARC replaces from T1 when it exceeds its target size, otherwise from T2
+    if (t1_min_index != -1 && (t1_size > target || min_index == -1)) return t1_min_index;
+    return min_index;
+}
+
+bool ShadowCache::request(Vertex* cargo_request) {
+    access++;
+    clock++;
+    if (cache_type == CacheType::TINYLFU) sketch.increment(cargo_request->id);
+
+    // LFU aging, same as live cache
+    if (cache_type == CacheType::LFU && ++aging >= 10 * capacity) {
+        for (auto& frequency : stamp) frequency = frequency / 2;
+        aging = 0;
+    }
+
+    auto it = std::find(cargo.begin(), cargo.end(), cargo_request);
+    if (it != cargo.end()) {
+        uint index = it - cargo.begin();
+        hit++;
+        switch (cache_type) {
+        case CacheType::LFU:
+            stamp[index]++;
+            break;
+        case CacheType::FIFO:
+            break;
+        default:
+            stamp[index] = clock;
+            frequent[index] = true;
+            break;
+        }
+        return true;
+    }
+
+    // Cache miss, find a place for the cargo
+    int index = cargo.size();
+    if (cargo.size() < capacity) {
+        cargo.push_back(cargo_request);
+        stamp.push_back(0);
+        frequent.push_back(false);
+    }
+    else {
+        if (capacity == 0) return false;
+        index = _get_evicted_index();
+        Vertex* victim = cargo[index];
+        if (cache_type == CacheType::TINYLFU && sketch.estimate(cargo_request->id) <= sketch.estimate(victim->id)) return false;
+        if (cache_type == CacheType::ARC) {
+            auto& ghost = frequent[index] ? ghost_frequent : ghost_recent;
+            ghost.push_back(victim);
+            if (ghost.size() > capacity) ghost.pop_front();
+        }
+        cargo[index] = cargo_request;
+    }
+
+    stamp[index] = cache_type == CacheType::LFU ? 1 : clock;
+    frequent[index] = false;
+    if (cache_type == CacheType::ARC) {
+        // Adapt target size of T1 with ghost hits
+        double b1_size = ghost_recent.size();
+        double b2_size = ghost_frequent.size();
+        auto it_b1 = std::find(ghost_recent.begin(), ghost_recent.end(), cargo_request);
+        auto it_b2 = std::find(ghost_frequent.begin(), ghost_frequent.end(), cargo_request);
+        if (it_b1 != ghost_recent.end()) {
+            target = std::min(double(capacity), target + std::max(b2_size / b1_size, 1.0));
+            ghost_recent.erase(it_b1);
+            frequent[index] = true;
+        }
+        else if (it_b2 != ghost_frequent.end()) {
+            target = std::max(0.0, target - std::max(b1_size / b2_size, 1.0));
+            ghost_frequent.erase(it_b2);
+            frequent[index] = true;
+        }
+    }
+    return false;
+}
+
+void ShadowCache::reset_statistics() {
+    hit = 0;
+    access = 0;
+}
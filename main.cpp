@@ -36,12 +36,12 @@ int main(int argc, char* argv[])
 
     if (!parser.debug_log && batch_idx % 100 == 0 && cache_access > 0 && is_cache(parser.cache_type)) {
       double cacheRate = static_cast<double>(cache_hit) / cache_access * 100.0;
-      console->info("Elapsed Time: {:5}ms   |   Goals Reached: {:5}   |   Cache Hit Rate: {:2.2f}%    |   Steps Used: {:5}", elapsed_time, i, cacheRate, makespan);
+      console->info("Elapsed Time: {:5}ms   |   Goals Reached: {:5}   |   Cache Hit Rate: {:2.2f}%    |   Steps Used: {:5}   |   P50 Steps: {:5}   |   P99 Steps: {:5}", elapsed_time, i, cacheRate, makespan, ins.cargo_steps.percentile(50), ins.cargo_steps.percentile(99));
       // Reset the timer
       timer = std::chrono::steady_clock::now();
     }
     else if (!parser.debug_log && batch_idx % 100 == 0 && !is_cache(parser.cache_type)) {
-      console->info("Elapsed Time: {:5}ms   |   Goals Reached: {:5}   |   Steps Used: {:5}", elapsed_time, i, makespan);
+      console->info("Elapsed Time: {:5}ms   |   Goals Reached: {:5}   |   Steps Used: {:5}   |   P50 Steps: {:5}   |   P99 Steps: {:5}", elapsed_time, i, makespan, ins.cargo_steps.percentile(50), ins.cargo_steps.percentile(99));
       // Reset the timer
       timer = std::chrono::steady_clock::now();
     }
@@ -58,7 +58,9 @@ int main(int argc, char* argv[])
     assert(deadline.reset());
 
     // Get solution
-    auto solution = solve(ins, &deadline, &parser.MT);
+    std::vector<size_t> reached;
+    std::vector<int> distances;
+    auto solution = solve(ins, &deadline, &parser.MT, &reached, &distances);
     const auto comp_time_ms = deadline.elapsed_ms();
 
     // Failure
@@ -71,8 +73,9 @@ int main(int argc, char* argv[])
     // Update step solution
     log.update_solution(solution, ins.bit_status);
 
-    // Check feasibility
-    if (!log.is_feasible_solution(ins)) {
+    // Check feasibility, of every N planning steps
+    bool check_feasibility = parser.feasibility_check_interval > 0 && batch_idx % parser.feasibility_check_interval == 0;
+    if (check_feasibility && !log.is_feasible_solution(ins)) {
       console->error("invalid solution");
       return 1;
     }
@@ -81,19 +84,25 @@ int main(int argc, char* argv[])
     makespan += (solution.size() - 1);
 
     // Post processing
-    log.print_stats(ins, comp_time_ms);
-    log.make_step_log(ins, parser.output_step_file, comp_time_ms, parser.map_file, parser.random_seed, parser.short_log_format);
+    log.print_stats(distances, comp_time_ms);
+    log.make_step_log(ins, distances, parser.output_step_file, comp_time_ms, parser.map_file, parser.random_seed, parser.short_log_format);
 
     // Assign new goals
     if (is_cache(parser.cache_type)) {
-      nagents_with_new_goals = ins.update_on_reaching_goals_with_cache(solution, parser.num_goals - i, cache_access, cache_hit);
+      nagents_with_new_goals = ins.update_on_reaching_goals_with_cache(solution, reached, parser.num_goals - i, cache_access, cache_hit);
     }
     else {
-      nagents_with_new_goals = ins.update_on_reaching_goals_without_cache(solution, parser.num_goals - i);
+      nagents_with_new_goals = ins.update_on_reaching_goals_without_cache(solution, reached, parser.num_goals - i);
     }
     console->debug("Reached Goals: {}", nagents_with_new_goals);
   }
 
+  // Wait for the last background feasibility check
+  if (!log.wait_feasibility_check()) {
+    console->error("invalid solution");
+    return 1;
+  }
+
   // Get percentiles
   std::vector<uint> step_percentiles = ins.compute_percentiles();
 
@@ -105,9 +114,47 @@ int main(int argc, char* argv[])
     console->info("Total Goals Reached: {:5}   |   Makespan: {:5}   |   P0 Steps: {:5}    |   P50 Steps: {:5}   |   P99 Steps: {:5}", parser.num_goals, makespan, step_percentiles[0], step_percentiles[2], step_percentiles[6]);
   }
 
+  if (is_cache(parser.cache_type) && parser.prefetch_window > 0) {
+    console->info("Total Prefetches: {:5}   |   Prefetch Hits: {:5}   |   Throughput: {:2.4f}", ins.graph.cache->prefetch_cnt, ins.graph.cache->prefetch_hit, static_cast<double>(parser.num_goals) / makespan);
+  }
+
+  if (is_cache(parser.cache_type) && parser.slotting_interval > 0) {
+    console->info("Slotting Tasks: {:5}   |   Average Steps: {:2.2f}   |   Throughput: {:2.4f}", ins.graph.slotting_cnt, ins.cargo_steps.mean(), static_cast<double>(parser.num_goals) / makespan);
+  }
+
+  if (parser.batch_assignment) {
+    console->info("Batch Assignments: {:5}   |   Throughput: {:2.4f}", ins.batch_assignment_cnt, static_cast<double>(parser.num_goals) / makespan);
+  }
+
+  if (parser.any_port) {
+    console->info("Port Deliveries: {}   |   Throughput: {:2.4f}", ins.port_deliveries, static_cast<double>(parser.num_goals) / makespan);
+  }
+
+  if (is_cache(parser.cache_type) && parser.request_coalescing) {
+    console->info("Coalesced Requests: {:5}   |   Throughput: {:2.4f}", ins.coalesce_cnt, static_cast<double>(parser.num_goals) / makespan);
+  }
+
+  if (parser.trip_capacity > 1) {
+    double items_per_trip = ins.trip_cnt == 0 ? .0 : static_cast<double>(ins.trip_item_cnt) / ins.trip_cnt;
+    double steps_per_trip = ins.trip_cnt == 0 ? .0 : static_cast<double>(ins.trip_step_cnt) / ins.trip_cnt;
+    console->info("Trips: {:5}   |   Cargo per Trip: {:2.2f}   |   Steps per Trip: {:2.2f}   |   Throughput: {:2.4f}", ins.trip_cnt, items_per_trip, steps_per_trip, static_cast<double>(parser.num_goals) / makespan);
+  }
+
+  if (is_cache(parser.cache_type) && parser.garbage_relocation) {
+    console->info("Garbage Relocations: {:5}", ins.graph.relocation_cnt);
+  }
+
+  if (is_cache(parser.cache_type) && parser.shared_cache) {
+    console->info("Shared Cache Borrows: {:5}   |   Final Quota: {}", ins.graph.cache->shared_borrow_cnt, ins.graph.cache->shared_quota);
+  }
+
+  if (parser.cache_type == CacheType::ADAPTIVE) {
+    console->info("Final Cache Policy: {}   |   Policy Switches: {:5}", get_cache_type_name(ins.graph.cache->cache_type), ins.graph.cache->adaptive_switch_cnt);
+  }
+
   auto end_time = std::chrono::steady_clock::now();
   auto running_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start).count();
-  log.make_life_long_log(ins, parser.output_visual_file);
+  log.make_life_long_log(ins);
   log.make_csv_log(total_cache_rate, makespan, &step_percentiles, parser.num_goals, running_time, false);
 
   return 0;
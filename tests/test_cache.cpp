@@ -53,6 +53,12 @@ TEST(Cache, cache_LRU_single_port_test)
     tmp_cache_node_id.push_back(cache_3);
     cache.node_id.push_back(tmp_cache_node_id);
 
+    std::vector<VertexInfo> vertex_info(81);
+    vertex_info[cache_1->id] = { VertexRole::CACHE, 0 };
+    vertex_info[cache_2->id] = { VertexRole::CACHE, 1 };
+    vertex_info[cache_3->id] = { VertexRole::CACHE, 2 };
+    cache.vertex_info = &vertex_info;
+
     std::vector<bool> tmp_cache_is_empty;
     tmp_cache_is_empty.push_back(false);
     tmp_cache_is_empty.push_back(false);
@@ -181,6 +187,12 @@ TEST(Cache, cache_FIFO_single_port_test)
     tmp_cache_node_id.push_back(cache_3);
     cache.node_id.push_back(tmp_cache_node_id);
 
+    std::vector<VertexInfo> vertex_info(81);
+    vertex_info[cache_1->id] = { VertexRole::CACHE, 0 };
+    vertex_info[cache_2->id] = { VertexRole::CACHE, 1 };
+    vertex_info[cache_3->id] = { VertexRole::CACHE, 2 };
+    cache.vertex_info = &vertex_info;
+
     std::vector<bool> tmp_cache_is_empty;
     tmp_cache_is_empty.push_back(false);
     tmp_cache_is_empty.push_back(false);
@@ -256,4 +268,267 @@ TEST(Cache, cache_FIFO_single_port_test)
     // Test `update_cargo_from_cache`
     ASSERT_EQ(true, cache.update_cargo_from_cache(cargo_1, cache_1));
     ASSERT_EQ(0, cache.bit_cache_get_lock[0][0]);
-}
\ No newline at end of file
+}
+TEST(Cache, cache_LFU_single_port_test)
+{
+    Parser cache_LFU_single_port_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LFU);
+    auto G = Graph(&cache_LFU_single_port_test_parser);
+    Cache* cache = G.cache;
+
+    Vertex* cargo_1 = G.cargo_vertices[0][0];
+    Vertex* cargo_2 = G.cargo_vertices[0][1];
+    Vertex* cargo_3 = G.cargo_vertices[0][2];
+    Vertex* cargo_4 = G.V[0];
+    Vertex* unloading_port = G.unloading_ports[0];
+
+    // Fill cache, all cargoes start with frequency 1
+    for (auto cargo : { cargo_1, cargo_2, cargo_3 }) {
+        CacheAccessResult result = cache->try_insert_cache(cargo, unloading_port);
+        ASSERT_EQ(true, result.result);
+        ASSERT_EQ(true, cache->update_cargo_into_cache(cargo, result.goal));
+    }
+    ASSERT_EQ(1, cache->LFU[0][2]);
+
+    // cargo_1 hit twice, cargo_3 hit once
+    for (auto cargo : { cargo_1, cargo_1, cargo_3 }) {
+        CacheAccessResult result = cache->try_cache_cargo(cargo);
+        ASSERT_EQ(true, result.result);
+        ASSERT_EQ(true, cache->update_cargo_from_cache(cargo, result.goal));
+    }
+    ASSERT_EQ(3, cache->LFU[0][0]);
+
+    // The least frequent cargo_2 is evicted
+    ASSERT_EQ(1, cache->_get_cache_evited_policy_index(0));
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][1], cargo_2), cache->try_cache_garbage_collection(cargo_4));
+}
+
+TEST(Cache, cache_ARC_single_port_test)
+{
+    Parser cache_ARC_single_port_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::ARC);
+    auto G = Graph(&cache_ARC_single_port_test_parser);
+    Cache* cache = G.cache;
+
+    Vertex* cargo_1 = G.cargo_vertices[0][0];
+    Vertex* cargo_2 = G.cargo_vertices[0][1];
+    Vertex* cargo_3 = G.cargo_vertices[0][2];
+    Vertex* cargo_4 = G.V[0];
+    Vertex* unloading_port = G.unloading_ports[0];
+
+    // Fill cache, all cargoes are in recent list T1
+    for (auto cargo : { cargo_1, cargo_2, cargo_3 }) {
+        CacheAccessResult result = cache->try_insert_cache(cargo, unloading_port);
+        ASSERT_EQ(true, cache->update_cargo_into_cache(cargo, result.goal));
+    }
+
+    // cargo_1 hit, move to frequent list T2
+    CacheAccessResult hit = cache->try_cache_cargo(cargo_1);
+    ASSERT_EQ(true, cache->update_cargo_from_cache(cargo_1, hit.goal));
+    ASSERT_EQ(true, cache->ARC_T2[0][0]);
+
+    // T1 exceeds target size 0, the least recent cargo_2 in T1 is evicted
+    Vertex* block = cache->node_id[0][1];
+    ASSERT_EQ(CacheAccessResult(true, block, cargo_2), cache->try_cache_garbage_collection(cargo_4));
+    ASSERT_EQ(1, cache->ARC_B1[0].size());
+    ASSERT_EQ(true, cache->clear_cargo_from_cache(cargo_2, block));
+
+    // cargo_2 comes back, ghost hit in B1 enlarges T1 target size
+    ASSERT_EQ(CacheAccessResult(true, block), cache->try_insert_cache(cargo_2, unloading_port));
+    ASSERT_EQ(1, cache->ARC_p[0]);
+    ASSERT_EQ(true, cache->ARC_T2[0][1]);
+    ASSERT_EQ(0, cache->ARC_B1[0].size());
+}
+
+TEST(Cache, cache_TINYLFU_single_port_test)
+{
+    Parser cache_TINYLFU_single_port_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::TINYLFU);
+    auto G = Graph(&cache_TINYLFU_single_port_test_parser);
+    Cache* cache = G.cache;
+
+    Vertex* cargo_1 = G.cargo_vertices[0][0];
+    Vertex* cargo_2 = G.cargo_vertices[0][1];
+    Vertex* cargo_3 = G.cargo_vertices[0][2];
+    Vertex* cargo_4 = G.V[0];
+    Vertex* unloading_port = G.unloading_ports[0];
+
+    for (auto cargo : { cargo_1, cargo_2, cargo_3 }) {
+        cache->record_cargo_request(cargo);
+        CacheAccessResult result = cache->try_insert_cache(cargo, unloading_port);
+        ASSERT_EQ(true, cache->update_cargo_into_cache(cargo, result.goal));
+    }
+
+    // One-off cargo is not admitted, no garbage collection
+    cache->record_cargo_request(cargo_4);
+    ASSERT_EQ(CacheAccessResult(false, cargo_4), cache->try_cache_garbage_collection(cargo_4));
+
+    // Frequently requested cargo evicts the LRU victim
+    cache->record_cargo_request(cargo_4);
+    cache->record_cargo_request(cargo_4);
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0], cargo_1), cache->try_cache_garbage_collection(cargo_4));
+}
+
+TEST(Cache, frequency_sketch_test)
+{
+    FrequencySketch sketch(64);
+    for (int i = 0; i < 5; i++) sketch.increment(7);
+    sketch.increment(8);
+
+    ASSERT_EQ(5, sketch.estimate(7));
+    ASSERT_EQ(1, sketch.estimate(8));
+    ASSERT_EQ(0, sketch.estimate(9));
+
+    // Counters saturate at 15
+    for (int i = 0; i < 20; i++) sketch.increment(7);
+    ASSERT_EQ(15, sketch.estimate(7));
+
+    // Aging halves counters
+    sketch.reset();
+    ASSERT_EQ(7, sketch.estimate(7));
+    ASSERT_EQ(0, sketch.estimate(8));
+}
+
+TEST(Cache, cache_distance_aware_single_port_test)
+{
+    Parser cache_distance_aware_single_port_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LRU);
+    cache_distance_aware_single_port_test_parser.distance_aware_cache = true;
+    auto G = Graph(&cache_distance_aware_single_port_test_parser);
+    Cache* cache = G.cache;
+
+    /* Graph
+        TTTTTTTT
+        T......T
+        T...CH.T
+        TU..CH.T
+        T...CH.T
+        T......T
+        T......T
+        TTTTTTTT
+    */
+
+    Vertex* cargo_1 = G.cargo_vertices[0][0];
+    Vertex* cargo_3 = G.cargo_vertices[0][2];
+    Vertex* unloading_port = G.unloading_ports[0];
+
+    // Cargo at the bottom is inserted into the bottom cache block
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][2]), cache->try_insert_cache(cargo_3, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_3, cache->node_id[0][2]));
+
+    // Cargo at the top is inserted into the top cache block
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0]), cache->try_insert_cache(cargo_1, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_1, cache->node_id[0][0]));
+}
+
+TEST(Cache, cache_shrink_single_port_test)
+{
+    Parser cache_shrink_single_port_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LRU);
+    auto G = Graph(&cache_shrink_single_port_test_parser);
+    Cache* cache = G.cache;
+    cache->shrink(1);
+
+    Vertex* cargo_1 = G.cargo_vertices[0][0];
+    Vertex* cargo_2 = G.cargo_vertices[0][1];
+    Vertex* unloading_port = G.unloading_ports[0];
+
+    // Only the first cache block is left
+    ASSERT_EQ(1, cache->node_id[0].size());
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0]), cache->try_insert_cache(cargo_1, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_1, cache->node_id[0][0]));
+
+    // Cache is full, the second cargo triggers garbage collection
+    ASSERT_EQ(CacheAccessResult(false, unloading_port), cache->try_insert_cache(cargo_2, unloading_port));
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0], cargo_1), cache->try_cache_garbage_collection(cargo_2));
+}
+
+TEST(Cache, shadow_cache_test)
+{
+    Vertex* cargo_1 = new Vertex(1, 1, 0, 0);
+    Vertex* cargo_2 = new Vertex(2, 2, 0, 0);
+    Vertex* cargo_3 = new Vertex(3, 3, 0, 0);
+
+    ShadowCache lru(CacheType::LRU, 2, 16);
+    ShadowCache fifo(CacheType::FIFO, 2, 16);
+
+    // Request: 1, 2, 1, 3, 1
+    for (Vertex* cargo : { cargo_1, cargo_2, cargo_1, cargo_3, cargo_1 }) {
+        lru.request(cargo);
+        fifo.request(cargo);
+    }
+
+    // LRU evicts cargo 2 and keeps cargo 1, FIFO evicts cargo 1
+    ASSERT_EQ(2, lru.hit);
+    ASSERT_EQ(1, fifo.hit);
+    ASSERT_EQ(5, lru.access);
+
+    lru.reset_statistics();
+    ASSERT_EQ(0, lru.hit);
+    ASSERT_EQ(0, lru.access);
+
+    delete cargo_1;
+    delete cargo_2;
+    delete cargo_3;
+}
+
+TEST(Cache, cache_ADAPTIVE_single_port_test)
+{
+    Parser cache_ADAPTIVE_single_port_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::ADAPTIVE);
+    cache_ADAPTIVE_single_port_test_parser.adaptive_epoch = 3;
+    auto G = Graph(&cache_ADAPTIVE_single_port_test_parser);
+    Cache* cache = G.cache;
+    cache->shrink(2);
+
+    Vertex* cargo_1 = G.cargo_vertices[0][0];
+    Vertex* cargo_2 = G.cargo_vertices[0][1];
+    Vertex* cargo_3 = G.cargo_vertices[0][2];
+
+    // Cyclic scan larger than the cache, LRU never hits while TinyLFU
+    // keeps two cargo after the first epoch
+    for (int epoch = 0; epoch < 4; epoch++) {
+        // Adaptive cache starts with LRU
+        ASSERT_EQ(CacheType::LRU, cache->cache_type);
+        for (Vertex* cargo : { cargo_1, cargo_2, cargo_3 }) cache->record_cargo_request(cargo);
+    }
+
+    // Switched after winning 3 epochs in a row
+    ASSERT_EQ(CacheType::TINYLFU, cache->cache_type);
+    ASSERT_EQ(1, cache->adaptive_switch_cnt);
+}
+
+TEST(Cache, cache_shared_multi_port_test)
+{
+    Parser cache_shared_multi_port_test_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU);
+    cache_shared_multi_port_test_parser.shared_cache = true;
+    cache_shared_multi_port_test_parser.agent_capacity = 2;
+    auto G = Graph(&cache_shared_multi_port_test_parser);
+    Cache* cache = G.cache;
+    cache->shrink(2);
+
+    Vertex* cargo_1 = G.cargo_vertices[1][0];
+    Vertex* cargo_2 = G.cargo_vertices[1][1];
+    Vertex* cargo_3 = G.cargo_vertices[1][2];
+    Vertex* unloading_port = G.unloading_ports[1];
+
+    // Fill cache blocks of group 1
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[1][0]), cache->try_insert_cache(cargo_1, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_1, cache->node_id[1][0]));
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[1][1]), cache->try_insert_cache(cargo_2, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_2, cache->node_id[1][1]));
+
+    // Group 1 is full, borrow a cache block of group 0
+    ASSERT_EQ(false, cache->_is_garbage_collection(1));
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0]), cache->try_insert_cache(cargo_3, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_3, cache->node_id[0][0]));
+    ASSERT_EQ(1, cache->shared_borrow_cnt);
+    ASSERT_EQ(3, cache->_get_shared_cache_usage(1));
+
+    // Borrowed block can be hit
+    ASSERT_EQ(0, cache->_get_cargo_in_cache_group(cargo_3));
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0]), cache->try_cache_cargo(cargo_3));
+    ASSERT_EQ(true, cache->update_cargo_from_cache(cargo_3, cache->node_id[0][0]));
+
+    // Block runs out of cargo and is reused, taken cargo is back in its own group
+    Vertex* cargo_4 = G.cargo_vertices[1][3];
+    ASSERT_EQ(CacheAccessResult(true, cache->node_id[0][0]), cache->try_insert_cache(cargo_4, unloading_port));
+    ASSERT_EQ(true, cache->update_cargo_into_cache(cargo_4, cache->node_id[0][0]));
+    ASSERT_EQ(0, cache->_get_cargo_in_cache_group(cargo_4));
+    ASSERT_EQ(1, cache->_get_cargo_in_cache_group(cargo_3));
+    ASSERT_EQ(-2, cache->_get_cargo_in_cache_position(cargo_3));
+}
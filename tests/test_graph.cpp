@@ -18,7 +18,7 @@ TEST(Graph, single_port_load_graph_test)
   ASSERT_EQ(G.cache->node_id.size(), 1);
   ASSERT_EQ(G.cache->node_id[0].size(), 3);
   ASSERT_EQ(G.goals_queue.size(), 1);
-  ASSERT_EQ(G.goals_queue[0].size(), 101);
+  ASSERT_EQ(G.goals_queue[0].size() + G.goals_generator[0].size(), 101);
 
   // Test normal block
   ASSERT_EQ(G.V[0]->neighbor.size(), 2);
@@ -61,8 +61,8 @@ TEST(Graph, multi_port_load_graph_test)
   ASSERT_EQ(G.cache->node_id[0].size(), 6);
   ASSERT_EQ(G.cache->node_id[1].size(), 4);
   ASSERT_EQ(G.goals_queue.size(), 2);
-  ASSERT_EQ(G.goals_queue[0].size(), 51);
-  ASSERT_EQ(G.goals_queue[1].size(), 51);
+  ASSERT_EQ(G.goals_queue[0].size() + G.goals_generator[0].size(), 51);
+  ASSERT_EQ(G.goals_queue[1].size() + G.goals_generator[1].size(), 51);
 
   // Test normal block
   ASSERT_EQ(G.V[0]->neighbor.size(), 2);
@@ -85,3 +85,418 @@ TEST(Graph, multi_port_load_graph_test)
   ASSERT_EQ(G.cache->node_id[0][0]->neighbor[0]->id, 16);
   ASSERT_EQ(G.cache->node_id[0][0]->neighbor[1]->id, 3);
 }
+
+TEST(Graph, distance_test)
+{
+  Parser distance_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LRU);
+  auto G = Graph(&distance_test_parser);
+
+  // Unloading port (1, 3) to cache block (4, 3)
+  ASSERT_EQ(G.get_distance(G.unloading_ports[0], G.cache->node_id[0][1]), 3);
+  ASSERT_EQ(G.get_distance(G.cache->node_id[0][1], G.unloading_ports[0]), 3);
+  // Cache block (4, 4) to cargo (5, 4), blocks are only reachable from aisle
+  ASSERT_EQ(G.get_distance(G.cache->node_id[0][2], G.cargo_vertices[0][2]), 3);
+  ASSERT_EQ(G.get_distance(G.V[0], G.V[0]), 0);
+}
+
+TEST(Graph, vertex_role_test)
+{
+  Parser vertex_role_test_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU);
+  auto G = Graph(&vertex_role_test_parser);
+
+  // Roles and slots of ports, cache blocks and shelves of the second group
+  ASSERT_TRUE(G.is_port(G.unloading_ports[1]));
+  ASSERT_EQ(G.get_vertex_info(G.unloading_ports[1]).slot, 1);
+  ASSERT_TRUE(G.is_cache_block(G.cache->node_id[1][3]));
+  ASSERT_EQ(G.get_vertex_info(G.cache->node_id[1][3]).slot, 3);
+  ASSERT_EQ(G.cache->_get_cache_block_in_cache_position(G.cache->node_id[1][3]), 3);
+  ASSERT_EQ(G.get_vertex_info(G.cargo_vertices[1][2]).role, VertexRole::SHELF);
+  ASSERT_EQ(G.get_vertex_info(G.cargo_vertices[1][2]).slot, 2);
+  ASSERT_EQ(G.get_vertex_info(G.V[0]).role, VertexRole::AISLE);
+  ASSERT_FALSE(G.is_port(G.V[0]));
+}
+
+TEST(Graph, garbage_relocation_test)
+{
+  Parser garbage_relocation_test_parser = Parser("./assets/test/test-8-8-free_shelf.map", CacheType::LRU);
+  garbage_relocation_test_parser.garbage_relocation = true;
+  auto G = Graph(&garbage_relocation_test_parser);
+
+  /* Graph
+      TTTTTTTT
+      T......T
+      T...CH.T
+      TU..CH.T
+      T...CH.T
+      T.E....T
+      T......T
+      TTTTTTTT
+  */
+
+  Vertex* garbage = G.cargo_vertices[0][0];
+  Vertex* next = G.cargo_vertices[0][2];
+  Vertex* block = G.cache->node_id[0][2];
+  Vertex* free_shelf = G.U[8 * 5 + 2];
+
+  ASSERT_EQ(G.free_shelves[0].size(), 1);
+  ASSERT_EQ(G.free_shelves[0][0], free_shelf);
+  ASSERT_EQ(G.get_cargo_location(garbage), garbage);
+
+  // Free shelf is on the way from cache block (4, 4) to next cargo (5, 4)
+  ASSERT_EQ(G.get_garbage_shelf(garbage, block, next), free_shelf);
+  ASSERT_EQ(G.free_shelves[0].size(), 0);
+
+  // Dropped at free shelf, old shelf becomes free
+  G.update_cargo_location(garbage, free_shelf);
+  ASSERT_EQ(G.get_cargo_location(garbage), free_shelf);
+  ASSERT_EQ(G.free_shelves[0].size(), 1);
+  ASSERT_EQ(G.free_shelves[0][0], garbage);
+  ASSERT_EQ(G.relocation_cnt, 1);
+
+  // Current shelf is already the closest, cargo stays there
+  ASSERT_EQ(G.get_garbage_shelf(garbage, block, next), free_shelf);
+  ASSERT_EQ(G.free_shelves[0].size(), 1);
+}
+
+TEST(Graph, slotting_test)
+{
+  Parser slotting_test_parser = Parser("./assets/test/test-8-8-free_shelf.map", CacheType::LRU);
+  auto G = Graph(&slotting_test_parser);
+
+  Vertex* cargo_1 = G.cargo_vertices[0][0];
+  Vertex* cargo_2 = G.cargo_vertices[0][1];
+  Vertex* free_shelf = G.U[8 * 5 + 2];
+  std::fill(G.cargo_demand.begin(), G.cargo_demand.end(), 0);
+
+  // No hot cargo, nothing to move
+  ASSERT_EQ(G.get_slotting_task(0).hot, nullptr);
+
+  // Hot cargo (5, 3) is 10 steps away from port, free shelf (2, 5) is 3
+  G.cargo_demand[cargo_2->id] = 5;
+  SlottingTask task = G.get_slotting_task(0);
+  ASSERT_EQ(task.hot, cargo_2);
+  ASSERT_EQ(task.cold, nullptr);
+  ASSERT_EQ(task.shelf, free_shelf);
+  ASSERT_EQ(G.free_shelves[0].size(), 0);
+  ASSERT_EQ(G.slotting_cargo.count(cargo_2), 1);
+
+  // Hot cargo dropped, its old shelf becomes free
+  G.update_slotting_location(task);
+  G.finish_slotting_task(task);
+  ASSERT_EQ(G.get_cargo_location(cargo_2), free_shelf);
+  ASSERT_EQ(G.free_shelves[0][0], cargo_2);
+  ASSERT_EQ(G.slotting_cargo.count(cargo_2), 0);
+  ASSERT_EQ(G.slotting_cnt, 1);
+
+  // No closer shelf for the less hot cargo (5, 2)
+  G.cargo_demand[cargo_1->id] = 3;
+  ASSERT_EQ(G.get_slotting_task(0).hot, nullptr);
+}
+
+TEST(Graph, slotting_relocation_test)
+{
+  Parser slotting_relocation_test_parser = Parser("./assets/test/test-8-8-free_shelf.map", CacheType::LRU);
+  slotting_relocation_test_parser.garbage_relocation = true;
+  auto G = Graph(&slotting_relocation_test_parser);
+
+  Vertex* cargo_1 = G.cargo_vertices[0][0];
+  Vertex* cargo_2 = G.cargo_vertices[0][1];
+  Vertex* block = G.cache->node_id[0][2];
+  Vertex* free_shelf = G.U[8 * 5 + 2];
+  std::fill(G.cargo_demand.begin(), G.cargo_demand.end(), 0);
+
+  // Cargo (5, 2) relocated to free shelf (2, 5), its old shelf becomes free
+  G.update_cargo_location(cargo_1, G.get_garbage_shelf(cargo_1, block, G.cargo_vertices[0][2]));
+  ASSERT_EQ(G.get_cargo_location(cargo_1), free_shelf);
+  ASSERT_EQ(G.free_shelves[0][0], cargo_1);
+
+  // Hot cargo (5, 3) swaps with cold cargo 1, the closest to port
+  G.cargo_demand[cargo_2->id] = 5;
+  SlottingTask task = G.get_slotting_task(0);
+  ASSERT_EQ(task.hot, cargo_2);
+  ASSERT_EQ(task.cold, cargo_1);
+  ASSERT_EQ(task.shelf, free_shelf);
+
+  // Cold cargo evicted during the swap, free shelf (5, 2) is closer but
+  // the reserved cargo stays on its shelf
+  ASSERT_EQ(G.get_garbage_shelf(cargo_1, G.cache->node_id[0][0], cargo_1), free_shelf);
+  G.update_cargo_location(cargo_1, free_shelf);
+  ASSERT_EQ(G.free_shelves[0].size(), 1);
+  ASSERT_EQ(G.relocation_cnt, 1);
+
+  // Swap finished, every shelf holds a single cargo
+  G.update_slotting_location(task);
+  G.finish_slotting_task(task);
+  ASSERT_EQ(G.get_cargo_location(cargo_2), free_shelf);
+  ASSERT_EQ(G.get_cargo_location(cargo_1), cargo_2);
+  ASSERT_EQ(G.free_shelves[0].size(), 1);
+  ASSERT_EQ(G.free_shelves[0][0], cargo_1);
+
+  // Cargo no longer reserved can be relocated again
+  ASSERT_EQ(G.get_garbage_shelf(cargo_1, G.cache->node_id[0][0], cargo_1), cargo_1);
+}
+
+TEST(Graph, alias_sampler_test)
+{
+  std::mt19937 MT(0);
+  AliasSampler sampler({ 0.5, 0.0, 0.3, 0.2 });
+  std::vector<int> count(4, 0);
+  for (int i = 0; i < 100000; i++) count[sampler.sample(&MT)]++;
+
+  // Zero weight is never sampled, others follow their weights
+  ASSERT_EQ(count[1], 0);
+  ASSERT_NEAR(count[0] / 100000.0, 0.5, 0.01);
+  ASSERT_NEAR(count[2] / 100000.0, 0.3, 0.01);
+  ASSERT_NEAR(count[3] / 100000.0, 0.2, 0.01);
+
+  // All zero weights fall back to uniform
+  AliasSampler uniform_sampler({ 0.0, 0.0 });
+  std::vector<int> uniform_count(2, 0);
+  for (int i = 0; i < 10000; i++) uniform_count[uniform_sampler.sample(&MT)]++;
+  ASSERT_NEAR(uniform_count[0] / 10000.0, 0.5, 0.05);
+}
+
+TEST(Graph, indexed_vertex_set_test)
+{
+  Vertex* v1 = new Vertex(1, 1, 0, 0);
+  Vertex* v2 = new Vertex(2, 2, 0, 0);
+  Vertex* v3 = new Vertex(3, 3, 0, 0);
+
+  IndexedVertexSet set;
+  ASSERT_TRUE(set.insert(v1));
+  ASSERT_TRUE(set.insert(v2));
+  ASSERT_TRUE(set.insert(v3));
+  ASSERT_FALSE(set.insert(v2));
+  ASSERT_EQ(set.size(), 3);
+
+  // Erase moves the last element into the hole
+  ASSERT_TRUE(set.erase(v1));
+  ASSERT_FALSE(set.erase(v1));
+  ASSERT_EQ(set.size(), 2);
+  ASSERT_EQ(set.at(0), v3);
+  ASSERT_EQ(set.at(1), v2);
+  ASSERT_TRUE(set.contains(v3));
+  ASSERT_FALSE(set.contains(v1));
+
+  delete v1;
+  delete v2;
+  delete v3;
+}
+
+TEST(Graph, lazy_goal_generator_test)
+{
+  Parser lazy_goal_generator_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LRU);
+  lazy_goal_generator_test_parser.num_goals = 100000;
+  lazy_goal_generator_test_parser.strategy_num_goals[0] = 100000;
+  auto G = Graph(&lazy_goal_generator_test_parser);
+
+  // Only a chunk is generated up front
+  uint buffer_size = lazy_goal_generator_test_parser.look_ahead_num + lazy_goal_generator_test_parser.prefetch_window + GOALS_CHUNK_SIZE;
+  ASSERT_EQ(G.goals_queue[0].size(), buffer_size);
+  ASSERT_EQ(G.goals_generator[0].size(), 100001 - buffer_size);
+
+  // Buffer is refilled lazily and stays bounded
+  for (uint i = 0; i < 10 * GOALS_CHUNK_SIZE; i++) {
+    ASSERT_NE(G.get_next_goal(0), nullptr);
+    ASSERT_LE(G.goals_queue[0].size(), buffer_size);
+    G._fill_goals_list(0);
+    ASSERT_GE(G.goals_queue[0].size(), uint(lazy_goal_generator_test_parser.look_ahead_num));
+  }
+  ASSERT_EQ(G.goals_queue[0].size() + G.goals_generator[0].size(), 100001 - 10 * GOALS_CHUNK_SIZE);
+}
+
+TEST(Graph, order_data_test)
+{
+  // Header row is skipped, product id is the first field, sparse ids are
+  // compacted in ascending order
+  std::string csv = "product,order\n2,10\n0,11\n2,12\n\n3000000000000,13";
+  uint64_t total = 0;
+  std::vector<uint64_t> count = parse_order_data(csv.data(), csv.size(), total);
+  ASSERT_EQ(total, 4);
+  ASSERT_EQ(count, std::vector<uint64_t>({ 1, 2, 1 }));
+
+  std::string file_path = testing::TempDir() + "order_data_test.csv";
+  std::remove((file_path + ".freq").c_str());
+  std::ofstream(file_path) << csv;
+
+  // First load writes the sidecar, second load reads it back
+  std::vector<float> prob_v = compute_frequency_from_file(file_path);
+  ASSERT_EQ(prob_v, std::vector<float>({ 0.25, 0.5, 0.25 }));
+  ASSERT_TRUE(std::ifstream(file_path + ".freq").good());
+  ASSERT_EQ(compute_frequency_from_file(file_path), prob_v);
+
+  std::remove(file_path.c_str());
+  std::remove((file_path + ".freq").c_str());
+}
+
+TEST(Graph, replay_goals_test)
+{
+  std::string file_path = testing::TempDir() + "replay_goals_test.csv";
+  std::ofstream(file_path) << "product,time\n7,1\n3,2\n7,3\n9,4\n";
+
+  Parser replay_goals_test_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU);
+  replay_goals_test_parser.goals_gen_strategy = GoalGenerationType::Replay;
+  replay_goals_test_parser.strategy_num_goals = { 0, 0, 0 };
+  replay_goals_test_parser.real_dist_file_path = file_path;
+  auto G = Graph(&replay_goals_test_parser);
+
+  // Products are dealt round-robin to groups by first appearance:
+  // 7 -> group 0 cargo 0, 3 -> group 1 cargo 0, 9 -> group 0 cargo 1
+  Vertex* cargo_7 = G.cargo_vertices[0][0];
+  Vertex* cargo_3 = G.cargo_vertices[1][0];
+  Vertex* cargo_9 = G.cargo_vertices[0][1];
+  ASSERT_EQ(G.replay_cargo.size(), 3);
+  ASSERT_EQ(G.goals_queue[0].goals[0], cargo_7);
+  ASSERT_EQ(G.goals_queue[0].goals[1], cargo_7);
+  ASSERT_EQ(G.goals_queue[0].goals[2], cargo_9);
+  ASSERT_EQ(G.goals_queue[1].goals[0], cargo_3);
+
+  // Orders are replayed in time order and rewind at the end of the file
+  ASSERT_EQ(G.get_next_goal(0), cargo_7);
+  ASSERT_EQ(G.get_next_goal(0), cargo_7);
+  ASSERT_EQ(G.get_next_goal(0), cargo_9);
+  ASSERT_EQ(G.get_next_goal(0), cargo_7);
+  ASSERT_GT(G.order_stream->rewind_cnt, 0);
+
+  std::remove(file_path.c_str());
+}
+
+TEST(Graph, replay_goals_buffer_test)
+{
+  // Every order is product 7 of group 0, group 1 gets none
+  std::string file_path = testing::TempDir() + "replay_goals_buffer_test.csv";
+  std::ofstream file(file_path);
+  file << "product,time\n";
+  for (int i = 0; i < 1000; i++) file << "7," << i << "\n";
+  file.close();
+
+  Parser replay_goals_buffer_test_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU);
+  replay_goals_buffer_test_parser.goals_gen_strategy = GoalGenerationType::Replay;
+  replay_goals_buffer_test_parser.strategy_num_goals = { 0, 0, 0 };
+  replay_goals_buffer_test_parser.real_dist_file_path = file_path;
+  auto G = Graph(&replay_goals_buffer_test_parser);
+  uint target = replay_goals_buffer_test_parser.look_ahead_num + replay_goals_buffer_test_parser.prefetch_window + GOALS_CHUNK_SIZE;
+
+  // Filling group 1 reads the whole file once, group 0 stays bounded and
+  // keeps the rest of its orders pending
+  ASSERT_EQ(G.goals_queue[0].size(), target);
+  ASSERT_EQ(G.replay_pending[0].size(), 1000 - target + 1);
+  ASSERT_EQ(G.goals_queue[1].size(), 0);
+  ASSERT_EQ(G.order_stream->rewind_cnt, 1);
+
+  // Group 1 is known to have no product, the file is not scanned again
+  size_t cursor = G.order_stream->cursor;
+  G._fill_goals_list(1);
+  ASSERT_EQ(G.order_stream->cursor, cursor);
+  ASSERT_EQ(G.order_stream->rewind_cnt, 1);
+
+  std::remove(file_path.c_str());
+}
+
+TEST(Graph, replay_goals_order_test)
+{
+  // Products 0 to 9 first appear in order, product p -> group p % 2,
+  // then group 0 gets four orders for every order of group 1
+  std::string file_path = testing::TempDir() + "replay_goals_order_test.csv";
+  std::vector<int> products;
+  for (int p = 0; p < 10; p++) products.push_back(p);
+  for (int i = 0; i < 600; i++) products.push_back(i % 5 == 4 ? (i * 3) % 10 | 1 : (i * 7) % 10 & ~1);
+  std::ofstream file(file_path);
+  file << "product,time\n";
+  for (size_t i = 0; i < products.size(); i++) file << products[i] << "," << i << "\n";
+  file.close();
+
+  Parser replay_goals_order_test_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU);
+  replay_goals_order_test_parser.goals_gen_strategy = GoalGenerationType::Replay;
+  replay_goals_order_test_parser.strategy_num_goals = { 0, 0, 0 };
+  replay_goals_order_test_parser.real_dist_file_path = file_path;
+  auto G = Graph(&replay_goals_order_test_parser);
+
+  // Orders of each group in file order, repeated after rewinds
+  std::vector<Vertices> expected(2);
+  for (int pass = 0; pass < 3; pass++) {
+    for (int p : products) expected[p % 2].push_back(G.cargo_vertices[p % 2][(p / 2) % G.cargo_vertices[p % 2].size()]);
+  }
+
+  // Group 0 is drained first, group 1 still gets every order in order
+  for (int group : { 0, 1 }) {
+    for (size_t i = 0; i < expected[group].size(); i++) ASSERT_EQ(G.get_next_goal(group), expected[group][i]) << "group " << group << " order " << i;
+  }
+
+  std::remove(file_path.c_str());
+}
+
+TEST(Graph, look_ahead_queue_test)
+{
+  Parser look_ahead_queue_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LRU);
+  auto G = Graph(&look_ahead_queue_test_parser);
+  Vertex* c0 = G.cargo_vertices[0][0];
+  Vertex* c1 = G.cargo_vertices[0][1];
+  Vertex* c2 = G.cargo_vertices[0][2];
+  Vertex* port = G.unloading_ports[0];
+
+  LookAheadQueue& queue = G.goals_queue[0];
+  queue.clear();
+  for (Vertex* goal : { c0, c1, c2, c0, c1 }) queue.push_back(goal);
+
+  // Cached goal is taken first, goals before it are passed over
+  CacheAccessResult insert = G.cache->try_insert_cache(c2, port);
+  ASSERT_TRUE(insert.result);
+  ASSERT_TRUE(G.cache->update_cargo_into_cache(c2, insert.goal));
+  G._sync_look_ahead_cache();
+  ASSERT_EQ(queue.pop(4, 2, G.cache), c2);
+  ASSERT_EQ(queue.size(), 4);
+  ASSERT_EQ(queue.get_delay(0), 1);
+  ASSERT_EQ(queue.get_delay(1), 1);
+  ASSERT_EQ(queue.get_delay(3), 0);
+
+  // Cache status changes of goals already in window are applied
+  insert = G.cache->try_insert_cache(c1, port);
+  ASSERT_TRUE(insert.result);
+  ASSERT_TRUE(G.cache->update_cargo_into_cache(c1, insert.goal));
+  G._sync_look_ahead_cache();
+  ASSERT_EQ(queue.pop(4, 2, G.cache), c1);
+  ASSERT_EQ(queue.get_delay(0), 2);
+
+  // Front goal reaching the delay limit is taken before cached goals
+  ASSERT_EQ(queue.pop(4, 2, G.cache), c0);
+  ASSERT_EQ(queue.front(), c0);
+  ASSERT_EQ(queue.get_delay(0), 0);
+
+  // Cached goal behind the front is still preferred
+  ASSERT_EQ(queue.pop(4, 2, G.cache), c1);
+  ASSERT_EQ(queue.get_delay(0), 1);
+  ASSERT_EQ(queue.pop(4, 2, G.cache), c0);
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(queue.pop(4, 2, G.cache), nullptr);
+}
+
+TEST(Graph, cost_aware_selection_test)
+{
+  Parser cost_aware_selection_test_parser = Parser("./assets/test/test-8-8-single_port.map", CacheType::LRU);
+  cost_aware_selection_test_parser.cost_aware_selection = true;
+  cost_aware_selection_test_parser.delay_deadline_limit = 2;
+  auto G = Graph(&cost_aware_selection_test_parser);
+  Vertex* port = G.unloading_ports[0];
+
+  // Sort cargo by trip cost from the unloading port
+  Vertices cargo = G.cargo_vertices[0];
+  std::sort(cargo.begin(), cargo.end(), [&](Vertex* a, Vertex* b) { return G.get_distance(port, a) < G.get_distance(port, b); });
+  ASSERT_LT(G.get_distance(port, cargo[0]), G.get_distance(port, cargo[2]));
+
+  // Cheapest trip in window is taken, goals before it are passed over
+  G.goals_queue[0].clear();
+  for (Vertex* goal : { cargo[2], cargo[0], cargo[2], cargo[2] }) G.goals_queue[0].push_back(goal);
+  ASSERT_EQ(G.get_next_goal(0, 3, port), cargo[0]);
+  ASSERT_EQ(G.goals_queue[0].get_delay(0), 1);
+
+  // Without agent position, the default look ahead is used
+  ASSERT_EQ(G.get_next_goal(0, 3), cargo[2]);
+
+  // Front goal reaching the delay limit is taken
+  G.goals_queue[0].clear();
+  for (Vertex* goal : { cargo[2], cargo[0], cargo[0], cargo[0] }) G.goals_queue[0].push_back(goal);
+  ASSERT_EQ(G.get_next_goal(0, 4, port), cargo[0]);
+  ASSERT_EQ(G.get_next_goal(0, 4, port), cargo[0]);
+  ASSERT_EQ(G.get_next_goal(0, 4, port), cargo[2]);
+}
@@ -32,9 +32,6 @@ TEST(Instance, state_machine_test)
   instance.graph.goals_queue[0].clear();
   instance.graph.goals_queue[0].push_back(instance.graph.cargo_vertices[0][1]);
   instance.graph.goals_queue[0].push_back(instance.graph.cargo_vertices[0][1]);
-  instance.graph.goals_delay[0].clear();
-  instance.graph.goals_delay[0].push_back(0);
-  instance.graph.goals_delay[0].push_back(0);
   instance.instance_console->info("Front goal {}", *(instance.graph.goals_queue[0].front()));
 
 
@@ -133,3 +130,297 @@ TEST(Instance, state_machine_test)
   ASSERT_EQ(0, instance.update_on_reaching_goals_with_cache(vertex_list, 100, cache_access, cache_hit));
   ASSERT_EQ(5, instance.bit_status[0]);
 }
+
+TEST(Instance, prefetch_state_machine_test)
+{
+  Parser prefetch_state_machine_test_parser = Parser("./assets/test/test_instance.map", CacheType::LRU, 1);
+  prefetch_state_machine_test_parser.prefetch_window = 10;
+  Instance instance(&prefetch_state_machine_test_parser);
+
+  uint cache_access = 0, cache_hit = 0;
+  Vertex* port = instance.graph.unloading_ports[0];
+  Vertex* cargo = instance.graph.cargo_vertices[0][1];
+
+  // Agent is delivering the last goal
+  instance.bit_status[0] = 5;
+  instance.goals[0] = port;
+  instance.cargo_goals[0] = instance.graph.cargo_vertices[0][0];
+  instance.graph.goals_queue[0].clear();
+  instance.graph.goals_queue[0].push_back(cargo);
+
+  // Status 5 -> Status 6, no remaining goal, agent is idle and prefetches upcoming cargo
+  std::vector<Config> vertex_list = { { port } };
+  ASSERT_EQ(1, instance.update_on_reaching_goals_with_cache(vertex_list, 1, cache_access, cache_hit));
+  ASSERT_EQ(6, instance.bit_status[0]);
+  ASSERT_EQ(cargo, instance.goals[0]);
+  ASSERT_EQ(1, instance.idle_agents);
+  ASSERT_EQ(Vertices({ cargo }), instance.prefetching_cargo);
+
+  // Status 6 -> Status 7, go to insert cargo into cache
+  vertex_list = { { cargo } };
+  ASSERT_EQ(0, instance.update_on_reaching_goals_with_cache(vertex_list, 0, cache_access, cache_hit));
+  ASSERT_EQ(7, instance.bit_status[0]);
+  ASSERT_EQ(instance.graph.cache->node_id[0][0], instance.goals[0]);
+  ASSERT_EQ(1, instance.idle_agents);
+  ASSERT_TRUE(instance.prefetching_cargo.empty());
+
+  // Status 7 -> Status 2, cache is full, agent gets prefetched cargo from cache
+  vertex_list = { { instance.goals[0] } };
+  ASSERT_EQ(0, instance.update_on_reaching_goals_with_cache(vertex_list, 0, cache_access, cache_hit));
+  ASSERT_EQ(2, instance.bit_status[0]);
+  ASSERT_EQ(0, instance.idle_agents);
+  ASSERT_EQ(1, instance.graph.cache->prefetch_cnt);
+  ASSERT_EQ(1, instance.graph.cache->prefetch_hit);
+}
+
+TEST(Instance, min_cost_assignment_test)
+{
+  // Greedy row by row would take 1 + 5 + 9, optimal is 2 + 7 + 4
+  std::vector<std::vector<int>> cost = { { 1, 2, 9 }, { 3, 5, 7 }, { 4, 6, 9 } };
+  std::vector<int> match = solve_min_cost_assignment(cost);
+  ASSERT_EQ(match, std::vector<int>({ 1, 2, 0 }));
+
+  // More columns than rows, every row gets a distinct column
+  std::vector<std::vector<int>> wide = { { 5, 1, 5, 5 }, { 5, 1, 2, 5 } };
+  ASSERT_EQ(solve_min_cost_assignment(wide), std::vector<int>({ 1, 2 }));
+  ASSERT_TRUE(solve_min_cost_assignment({}).empty());
+}
+
+TEST(Instance, batch_assignment_test)
+{
+  Parser default_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU, 8);
+  Parser batch_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::LRU, 8);
+  batch_parser.batch_assignment = true;
+  Instance default_instance(&default_parser);
+  Instance batch_instance(&batch_parser);
+
+  // Same starts and goals, matched to agents of the same group with less travel
+  int default_distance = 0, batch_distance = 0;
+  for (uint j = 0; j < 8; j++) {
+    ASSERT_EQ(default_instance.starts[j]->id, batch_instance.starts[j]->id);
+    ASSERT_EQ(batch_instance.cargo_goals[j]->group, batch_instance.agent_group[j]);
+    default_distance += default_instance.graph.get_distance(default_instance.starts[j], default_instance.goals[j]);
+    batch_distance += batch_instance.graph.get_distance(batch_instance.starts[j], batch_instance.goals[j]);
+  }
+  ASSERT_LE(batch_distance, default_distance);
+  ASSERT_EQ(batch_instance.batch_assignment_cnt, 2);
+}
+
+TEST(Instance, batch_assignment_without_cache_test)
+{
+  Parser batch_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::NONE, 8);
+  batch_parser.batch_assignment = true;
+  Instance instance(&batch_parser);
+  uint batch_cnt = instance.batch_assignment_cnt;
+
+  // Two agents of group 0 deliver at its port in the same step
+  std::vector<size_t> batch;
+  for (size_t j = 0; j < 8 && batch.size() < 2; j++) {
+    if (instance.agent_group[j] == 0) batch.push_back(j);
+  }
+  ASSERT_EQ(batch.size(), 2);
+  Vertex* port = instance.graph.unloading_ports[0];
+  Config positions = instance.starts;
+  for (auto j : batch) {
+    instance.goals[j] = port;
+    positions[j] = port;
+  }
+  std::vector<Config> vertex_list = { instance.starts, positions };
+
+  // Both are matched to the next goals of group 0 together
+  ASSERT_EQ(instance.update_on_reaching_goals_without_cache(vertex_list, batch, 100), 2);
+  ASSERT_EQ(instance.batch_assignment_cnt, batch_cnt + 1);
+  for (auto j : batch) {
+    ASSERT_EQ(instance.cargo_goals[j]->group, 0);
+    ASSERT_EQ(instance.goals[j], instance.cargo_goals[j]);
+  }
+}
+
+TEST(Instance, in_flight_cache_hit_test)
+{
+  Parser in_flight_test_parser = Parser("./assets/test/test_instance.map", CacheType::LRU, 2);
+  Instance instance(&in_flight_test_parser);
+
+  uint cache_access = 0, cache_hit = 0;
+  Vertex* cargo = instance.graph.cargo_vertices[0][0];
+  Vertex* block = instance.graph.cache->node_id[0][0];
+
+  // Agent 0 is inserting the cargo into cache, agent 1 is fetching it from warehouse
+  for (size_t j = 0; j < 2; j++) {
+    instance._stop_fetching(j);
+    instance.cargo_goals[j] = cargo;
+    instance.goals[j] = instance.graph.get_cargo_location(cargo);
+    instance.bit_status[j] = 1;
+    instance._start_fetching(j);
+  }
+  std::vector<Config> vertex_list = { { instance.goals[0], instance.starts[1] } };
+  instance.update_on_reaching_goals_with_cache(vertex_list, { 0 }, 100, cache_access, cache_hit);
+  ASSERT_EQ(4, instance.bit_status[0]);
+  ASSERT_EQ(block, instance.goals[0]);
+  ASSERT_EQ(1, instance.bit_status[1]);
+
+  // Status 1 -> Status 2, the cargo is cached while agent 1 is on the way
+  vertex_list = { { block, instance.starts[1] } };
+  instance.update_on_reaching_goals_with_cache(vertex_list, { 0 }, 100, cache_access, cache_hit);
+  ASSERT_EQ(5, instance.bit_status[0]);
+  ASSERT_EQ(2, instance.bit_status[1]);
+  ASSERT_EQ(block, instance.goals[1]);
+  ASSERT_EQ(1, cache_hit);
+  ASSERT_TRUE(instance.fetching_agents.empty());
+}
+
+TEST(Instance, multi_item_trip_test)
+{
+  Parser trip_test_parser = Parser("./assets/test/test_instance.map", CacheType::NONE, 1);
+  trip_test_parser.trip_capacity = 2;
+  Instance instance(&trip_test_parser);
+
+  Vertex* port = instance.graph.unloading_ports[0];
+  Vertex* near = instance.graph.cargo_vertices[0][0];
+  Vertex* far = instance.graph.cargo_vertices[0][0];
+  for (auto cargo : instance.graph.cargo_vertices[0]) {
+    if (instance.graph.get_distance(port, cargo) < instance.graph.get_distance(port, near)) near = cargo;
+    if (instance.graph.get_distance(port, cargo) > instance.graph.get_distance(port, far)) far = cargo;
+  }
+  ASSERT_NE(near, far);
+
+  // Agent at unloading port takes two goals, and picks the nearest first
+  instance.goals[0] = port;
+  instance.graph.goals_queue[0].clear();
+  instance.graph.goals_queue[0].push_back(far);
+  instance.graph.goals_queue[0].push_back(near);
+  std::vector<Config> vertex_list = { { port } };
+  ASSERT_EQ(1, instance.update_on_reaching_goals_without_cache(vertex_list, 100));
+  ASSERT_EQ(near, instance.goals[0]);
+  ASSERT_EQ(2, instance.trip_items[0]);
+
+  // Then the other cargo, and back to unloading port
+  vertex_list = { { near } };
+  ASSERT_EQ(0, instance.update_on_reaching_goals_without_cache(vertex_list, 100));
+  ASSERT_EQ(far, instance.goals[0]);
+  vertex_list = { { far } };
+  ASSERT_EQ(0, instance.update_on_reaching_goals_without_cache(vertex_list, 100));
+  ASSERT_EQ(port, instance.goals[0]);
+
+  // Both cargo are delivered together
+  vertex_list = { { port } };
+  ASSERT_EQ(2, instance.update_on_reaching_goals_without_cache(vertex_list, 100));
+  ASSERT_EQ(2, instance.trip_cnt);
+  ASSERT_EQ(3, instance.trip_item_cnt);
+}
+
+TEST(Instance, request_coalescing_test)
+{
+  Parser coalescing_test_parser = Parser("./assets/test/test_instance.map", CacheType::LRU, 2);
+  coalescing_test_parser.request_coalescing = true;
+  Instance instance(&coalescing_test_parser);
+
+  uint cache_access = 0, cache_hit = 0;
+  Vertex* cargo = instance.graph.cargo_vertices[0][0];
+  Vertex* port = instance.graph.unloading_ports[0];
+
+  // Agent 0 is bringing the cargo into cache
+  instance._stop_fetching(0);
+  instance._stop_fetching(1);
+  instance.cargo_goals[0] = cargo;
+  CacheAccessResult result = instance.graph.cache->try_insert_cache(cargo, port);
+  ASSERT_TRUE(result.result);
+  Vertex* block = result.goal;
+  instance.bit_status[0] = 4;
+  instance.goals[0] = block;
+
+  // Status 11, agent 1 requests the same cargo and waits for it at the cache block
+  instance._assign_cargo(1, port, cargo, cache_access, cache_hit);
+  ASSERT_EQ(11, instance.bit_status[1]);
+  ASSERT_EQ(block, instance.goals[1]);
+  ASSERT_EQ(1, instance.coalesce_cnt);
+
+  // Waiting agent at the cache block does not end the planning step
+  ASSERT_FALSE(instance.is_goal_reached({ port, block }));
+  ASSERT_TRUE(instance.is_goal_reached({ block, port }));
+
+  // Status 11 -> Status 2, cargo is inserted
+  std::vector<Config> vertex_list = { { block, port } };
+  instance.update_on_reaching_goals_with_cache(vertex_list, { 0 }, 100, cache_access, cache_hit);
+  ASSERT_EQ(5, instance.bit_status[0]);
+  ASSERT_EQ(2, instance.bit_status[1]);
+  ASSERT_EQ(block, instance.goals[1]);
+  ASSERT_EQ(1, cache_access);
+  ASSERT_EQ(1, cache_hit);
+  ASSERT_TRUE(instance.waiting_agents.empty());
+}
+
+TEST(Instance, any_port_delivery_test)
+{
+  Parser any_port_test_parser = Parser("./assets/test/test-16-16-multi_port.map", CacheType::NONE, 2);
+  any_port_test_parser.any_port = true;
+  Instance instance(&any_port_test_parser);
+
+  Vertex* port_0 = instance.graph.unloading_ports[0];
+  Vertex* port_1 = instance.graph.unloading_ports[1];
+  Vertex* cargo = instance.graph.cargo_vertices[0][0];
+
+  // Agent 0 of group 0 delivers its cargo at the port of group 1, which is closer
+  instance.agent_group[0] = 0;
+  instance.cargo_goals[0] = cargo;
+  instance._go_to_port(0, port_1);
+  ASSERT_EQ(port_1, instance.goals[0]);
+  ASSERT_EQ(1, instance.port_load[1]);
+
+  // Agents heading to a port make it congested
+  ASSERT_EQ(port_1, instance._get_delivery_port(1, port_1));
+  instance.port_load[1] += instance.graph.get_distance(port_0, port_1) / PORT_CONGESTION_WEIGHT;
+  ASSERT_EQ(port_0, instance._get_delivery_port(1, port_1));
+  instance.port_load[1] = 1;
+
+  // Agent joins the group of the port
+  instance._arrive_at_port(0);
+  ASSERT_EQ(1, instance.agent_group[0]);
+  ASSERT_EQ(0, instance.port_load[1]);
+  ASSERT_EQ(1, instance.port_deliveries[1]);
+
+  // Without any-port delivery, cargo goes to the port of its group
+  any_port_test_parser.any_port = false;
+  ASSERT_EQ(port_0, instance._get_delivery_port(0, port_1));
+}
+
+TEST(Instance, step_histogram_test)
+{
+  StepHistogram histogram;
+  ASSERT_TRUE(histogram.empty());
+  ASSERT_EQ(histogram.percentile(50), 0);
+
+  // Small steps are counted exactly, same as sorting
+  std::vector<uint> steps;
+  std::mt19937 MT(0);
+  for (int i = 0; i < 1000; i++) {
+    steps.push_back(MT() % 200);
+    histogram.record(steps.back());
+  }
+  std::sort(steps.begin(), steps.end());
+  auto percentiles = histogram.percentiles({ 0, 25, 50, 75, 90, 95, 99, 100 });
+  ASSERT_EQ(percentiles[0], steps[0]);
+  ASSERT_EQ(percentiles[1], steps[250]);
+  ASSERT_EQ(percentiles[2], steps[500]);
+  ASSERT_EQ(percentiles[6], steps[990]);
+  ASSERT_EQ(percentiles[7], steps[999]);
+  ASSERT_EQ(histogram.size(), 1000);
+  ASSERT_NEAR(histogram.mean(), std::accumulate(steps.begin(), steps.end(), 0.0) / 1000, 1e-9);
+
+  // Large steps within relative error of sub buckets, min and max are exact
+  StepHistogram large_histogram;
+  steps.clear();
+  for (int i = 0; i < 1000; i++) {
+    steps.push_back(MT() % 1000000);
+    large_histogram.record(steps.back());
+  }
+  std::sort(steps.begin(), steps.end());
+  ASSERT_EQ(large_histogram.percentile(0), steps[0]);
+  ASSERT_EQ(large_histogram.percentile(100), steps[999]);
+  for (int p : { 25, 50, 75, 99 }) {
+    uint exact = steps[p * 10];
+    uint value = large_histogram.percentile(p);
+    ASSERT_GE(value, exact);
+    ASSERT_LE(value - exact, exact / STEP_HISTOGRAM_SUB_BUCKETS);
+  }
+}
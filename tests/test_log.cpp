@@ -0,0 +1,156 @@
+#include <calmapf.hpp>
+#include "gtest/gtest.h"
+
+TEST(Log, ring_buffer_test)
+{
+  RingBuffer<int> buffer(2);
+  int item = 1;
+  ASSERT_TRUE(buffer.push(item));
+  item = 2;
+  ASSERT_TRUE(buffer.push(item));
+  item = 3;
+  ASSERT_FALSE(buffer.push(item));
+
+  // First in first out
+  ASSERT_TRUE(buffer.pop(item));
+  ASSERT_EQ(item, 1);
+  ASSERT_TRUE(buffer.pop(item));
+  ASSERT_EQ(item, 2);
+  ASSERT_FALSE(buffer.pop(item));
+  ASSERT_TRUE(buffer.empty());
+
+  // Producer and consumer on different threads
+  RingBuffer<int> shared_buffer(4);
+  long long sum = 0;
+  std::thread consumer([&]() {
+    int value;
+    for (int received = 0; received < 10000;) {
+      if (shared_buffer.pop(value)) {
+        sum += value;
+        received++;
+      }
+      else std::this_thread::yield();
+    }
+    });
+  for (int i = 1; i <= 10000; i++) {
+    int value = i;
+    while (!shared_buffer.push(value)) std::this_thread::yield();
+  }
+  consumer.join();
+  ASSERT_EQ(sum, 50005000);
+}
+
+TEST(Log, feasibility_check_test)
+{
+  Parser feasibility_check_test_parser = Parser("./assets/test/test_instance.map", CacheType::LRU, 2);
+  feasibility_check_test_parser.output_step_file = "/tmp/feasibility_check_test_step.txt";
+  feasibility_check_test_parser.output_csv_file = "/tmp/feasibility_check_test.csv";
+  feasibility_check_test_parser.output_throughput_file = "/tmp/feasibility_check_test_throughput.csv";
+  feasibility_check_test_parser.output_visual_file = "/tmp/feasibility_check_test_vis.yaml";
+  Instance instance(&feasibility_check_test_parser);
+  Log log(&feasibility_check_test_parser);
+  int V = instance.graph.size();
+
+  // Three cells in a row and a far cell
+  Vertex* a = instance.graph.U[9];
+  Vertex* b = instance.graph.U[10];
+  Vertex* c = instance.graph.U[11];
+  Vertex* far = instance.graph.U[54];
+
+  // Following and waiting are feasible
+  ASSERT_TRUE(log.is_conflict_free({ { a, b }, { b, c }, { b, c } }, V));
+  // Vertex conflict
+  ASSERT_FALSE(log.is_conflict_free({ { a, c }, { b, b } }, V));
+  // Swap conflict
+  ASSERT_FALSE(log.is_conflict_free({ { a, b }, { b, a } }, V));
+  // Move to a non-neighbor
+  ASSERT_FALSE(log.is_conflict_free({ { a, c }, { far, c } }, V));
+  // Occupancy of earlier solutions is not mistaken for conflicts
+  ASSERT_TRUE(log.is_conflict_free({ { b, a }, { c, a } }, V));
+
+  // No background check pending
+  ASSERT_TRUE(log.wait_feasibility_check());
+}
+
+TEST(Log, lifelong_log_test)
+{
+  Parser lifelong_log_test_parser = Parser("./assets/test/test_instance.map", CacheType::LRU, 2);
+  lifelong_log_test_parser.output_step_file = "/tmp/lifelong_log_test_step.txt";
+  lifelong_log_test_parser.output_csv_file = "/tmp/lifelong_log_test.csv";
+  lifelong_log_test_parser.output_throughput_file = "/tmp/lifelong_log_test_throughput.csv";
+  lifelong_log_test_parser.output_visual_file = "/tmp/lifelong_log_test_vis.yaml";
+  std::remove(lifelong_log_test_parser.output_visual_file.c_str());
+  Instance instance(&lifelong_log_test_parser);
+
+  // Agent 0 moves back and forth, agent 1 waits, over more than two chunks
+  Vertex* a = instance.graph.U[9];
+  Vertex* b = instance.graph.U[10];
+  Vertex* c = instance.graph.U[12];
+  uint steps = 2 * TRAJECTORY_CHUNK_SIZE + 102;
+  {
+    Log log(&lifelong_log_test_parser);
+    // Batches of 10 steps, each starting from the last configuration
+    for (uint k = 0; k < steps; k += 10) {
+      Solution solution;
+      for (uint t = k; t <= k + 10; t++) solution.push_back({ t % 2 == 0 ? a : b, c });
+      log.update_solution(solution, { k / 10, 5 });
+    }
+    ASSERT_EQ(log.trajectory_steps, steps + 1);
+    ASSERT_EQ(log.spilled_chunks, 2);
+    log.make_life_long_log(instance);
+  }
+
+  // Spill file is removed, entries are read back in order of agents and timesteps
+  ASSERT_FALSE(std::ifstream(lifelong_log_test_parser.output_visual_file + ".spill").good());
+  std::ifstream visual(lifelong_log_test_parser.output_visual_file);
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(visual, line);) lines.push_back(line);
+  ASSERT_EQ(lines.size(), 3 + 2 * (1 + 4 * (steps + 1)));
+  ASSERT_EQ(lines[3], "  agent0:");
+  // Timestep 1500 of agent 0 is in the second spilled chunk
+  size_t entry = 4 + 4 * 1500;
+  ASSERT_EQ(lines[entry], "    - x: 1");
+  ASSERT_EQ(lines[entry + 1], "      y: 1");
+  ASSERT_EQ(lines[entry + 2], "      t: 1500");
+  ASSERT_EQ(lines[entry + 3], "      s: 149");
+  ASSERT_EQ(lines[4 + 4 * (steps + 1)], "  agent1:");
+  ASSERT_EQ(lines.back(), "      s: 5");
+}
+
+TEST(Log, lifelong_log_recover_test)
+{
+  Parser lifelong_log_recover_test_parser = Parser("./assets/test/test_instance.map", CacheType::LRU, 2);
+  lifelong_log_recover_test_parser.output_step_file = "/tmp/lifelong_log_recover_test_step.txt";
+  lifelong_log_recover_test_parser.output_csv_file = "/tmp/lifelong_log_recover_test.csv";
+  lifelong_log_recover_test_parser.output_throughput_file = "/tmp/lifelong_log_recover_test_throughput.csv";
+  lifelong_log_recover_test_parser.output_visual_file = "/tmp/lifelong_log_recover_test_vis.yaml";
+  Instance instance(&lifelong_log_recover_test_parser);
+
+  // Run stops without making the lifelong log, as after a crash
+  Vertex* a = instance.graph.U[9];
+  Vertex* b = instance.graph.U[10];
+  uint steps = TRAJECTORY_CHUNK_SIZE + 10;
+  {
+    Log log(&lifelong_log_recover_test_parser);
+    for (uint k = 0; k < steps; k += 10) {
+      Solution solution;
+      for (uint t = k; t <= k + 10; t++) solution.push_back({ a, b });
+      log.update_solution(solution, { 1, 2 });
+    }
+    ASSERT_EQ(log.spilled_chunks, 1);
+  }
+
+  // Spilled chunk is recovered, the partial chunk in memory is lost
+  std::string spill_file = lifelong_log_recover_test_parser.output_visual_file + ".spill";
+  std::stringstream visual;
+  ASSERT_TRUE(write_trajectory_yaml(spill_file, visual, instance.graph.width, instance.graph.height));
+  std::remove(spill_file.c_str());
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(visual, line);) lines.push_back(line);
+  ASSERT_EQ(lines.size(), 3 + 2 * (1 + 4 * TRAJECTORY_CHUNK_SIZE));
+  ASSERT_EQ(lines[4 + 4 * TRAJECTORY_CHUNK_SIZE], "  agent1:");
+  ASSERT_EQ(lines[lines.size() - 2], "      t: " + std::to_string(TRAJECTORY_CHUNK_SIZE - 1));
+
+  // Missing spill file
+  ASSERT_FALSE(write_trajectory_yaml(spill_file, visual, instance.graph.width, instance.graph.height));
+}
@@ -0,0 +1,67 @@
+// Goal generation benchmark
+// Measures goal sampler throughput and goals list generation of a map.
+// Author: Zhenghong Yu
+
+#include <argparse/argparse.hpp>
+#include <calmapf.hpp>
+#include <boost/random/discrete_distribution.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsed_sec(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+  // Set up logger
+  auto console = spdlog::stderr_color_mt("console");
+  console->set_level(spdlog::level::info);
+
+  // Benchmark arguments, common arguments are handled by Parser
+  argparse::ArgumentParser program("BENCH-GOALS", "0.1.0");
+  program.add_argument("-bs", "--bench-samples").help("Number of samples drawn by each sampler. Defaults to 10000000.").default_value(std::string("10000000"));
+  try {
+    program.parse_known_args(argc, argv);
+  }
+  catch (const std::runtime_error& err) {
+    console->error("{}", err.what());
+    std::exit(1);
+  }
+
+  Parser parser(argc, argv);
+  uint samples = std::stoul(program.get<std::string>("--bench-samples"));
+  Graph graph(&parser);
+  spdlog::get("graph")->set_level(spdlog::level::warn);
+
+  // Sampler throughput on Zhang probabilities of the first group
+  std::vector<double> item_prob = calculate_probabilities(graph.cargo_vertices[0].size());
+  uint64_t checksum = 0;
+
+  auto start = Clock::now();
+  boost::random::discrete_distribution<> dist(item_prob);
+  for (uint i = 0; i < samples; i++) checksum += dist(parser.MT);
+  double discrete_sec = elapsed_sec(start);
+
+  start = Clock::now();
+  AliasSampler sampler(item_prob);
+  for (uint i = 0; i < samples; i++) checksum += sampler.sample(&parser.MT);
+  double alias_sec = elapsed_sec(start);
+
+  console->info("Items: {:5}   |   Samples: {:10}   |   Checksum: {}", item_prob.size(), samples, checksum);
+  console->info("discrete_distribution: {:8.3f}s   |   {:12.0f} samples/s", discrete_sec, samples / discrete_sec);
+  console->info("alias sampler:         {:8.3f}s   |   {:12.0f} samples/s", alias_sec, samples / alias_sec);
+
+  // Goal generation with the parser strategy, drain every group generator
+  start = Clock::now();
+  uint goals = 0;
+  for (int group = 0; group < graph.group; group++) {
+    goals += graph.goals_generator[group].size();
+    while (Vertex* goal = graph.goals_generator[group].next()) checksum += goal->id;
+  }
+  double fill_sec = elapsed_sec(start);
+  console->info("{} goals:  {:8.3f}s   |   {:12.0f} goals/s   |   Checksum: {}", parser.goals_gen_strategy_input, fill_sec, goals / fill_sec, checksum);
+
+  return 0;
+}
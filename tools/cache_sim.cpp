@@ -0,0 +1,232 @@
+// Trace-driven cache simulator
+// Replays a goal sequence through Cache with a travel-time model derived
+// from shortest path distances, without running the MAPF planner.
+// Author: Zhenghong Yu
+
+#include <argparse/argparse.hpp>
+#include <calmapf.hpp>
+#include <queue>
+
+struct SimAgent {
+  uint group;
+  uint status;        // same meaning as Instance::bit_status
+  Vertex* position;
+  Vertex* goal;
+  Vertex* cargo;
+  Vertex* garbage;
+  uint trip_start;    // time the current task is assigned
+};
+
+struct SimResult {
+  uint hit = 0;
+  uint access = 0;
+  uint makespan = 0;
+  uint64_t steps = 0;
+};
+
+static std::vector<std::string> split(const std::string& input, char delimiter)
+{
+  std::vector<std::string> tokens;
+  std::stringstream ss(input);
+  std::string token;
+  while (std::getline(ss, token, delimiter)) {
+    if (!token.empty()) tokens.push_back(token);
+  }
+  return tokens;
+}
+
+// Goals file format: one goal per line, "x,y" coordinates of a cargo vertex
+static void load_goals(Graph& graph, const std::string& file_path)
+{
+  std::ifstream file(file_path);
+  if (!file) {
+    spdlog::get("console")->error("goals file {} is not found.", file_path);
+    exit(1);
+  }
+
+  // Goals come from the file only, generators are disabled
+  for (auto& generator : graph.goals_generator) generator = GoalGenerator();
+  for (auto& queue : graph.goals_queue) queue.clear();
+
+  std::string line;
+  while (std::getline(file, line)) {
+    auto coordinate = split(line, ',');
+    if (coordinate.size() != 2) continue;
+    int x = std::stoi(coordinate[0]);
+    int y = std::stoi(coordinate[1]);
+    Vertex* goal = (x >= 0 && x < graph.width && y >= 0 && y < graph.height) ? graph.U[graph.width * y + x] : nullptr;
+    if (goal == nullptr || !goal->cargo) {
+      spdlog::get("console")->error("goal ({}, {}) is not a cargo vertex.", x, y);
+      exit(1);
+    }
+    graph.goals_queue[goal->group].push_back(goal);
+  }
+}
+
+// Agent gets a new task at the unloading port, mirrors Instance logic
+static void assign(Graph& graph, Parser& parser, SimAgent& agent, SimResult& result, uint time)
+{
+  Vertex* cargo = graph.get_next_goal(agent.group, parser.look_ahead_num, agent.position);
+  graph.cache->record_cargo_request(cargo);
+  agent.cargo = cargo;
+  agent.trip_start = time;
+  result.access++;
+
+  CacheAccessResult hit = graph.cache->try_cache_cargo(cargo);
+  if (hit.result) {
+    result.hit++;
+    agent.status = 2;
+    agent.goal = hit.goal;
+    return;
+  }
+
+  CacheAccessResult trash = graph.cache->try_cache_garbage_collection(cargo, agent.position, graph.unloading_ports[cargo->group]);
+  if (trash.result) {
+    agent.status = 0;
+    agent.goal = trash.goal;
+    agent.garbage = trash.garbage;
+  }
+  else {
+    agent.status = 1;
+    agent.goal = graph.get_cargo_location(cargo);
+  }
+}
+
+// Cache updates must succeed, otherwise hit rates are meaningless
+static void check_cache_update(bool updated, const char* action, Vertex* cargo)
+{
+  if (updated) return;
+  spdlog::get("console")->error("failed to {} cargo {}.", action, *cargo);
+  exit(1);
+}
+
+// Agent reaches its goal, returns true if a cargo is delivered
+static bool reach(Graph& graph, SimAgent& agent)
+{
+  Vertex* port = graph.unloading_ports[agent.group];
+  switch (agent.status) {
+  case 0:
+    check_cache_update(graph.cache->clear_cargo_from_cache(agent.garbage, agent.goal), "clear", agent.garbage);
+    agent.status = 3;
+    agent.goal = graph.get_garbage_shelf(agent.garbage, agent.goal, graph.get_cargo_location(agent.cargo));
+    return false;
+  case 3:
+    graph.update_cargo_location(agent.garbage, agent.goal);
+    agent.status = 1;
+    agent.goal = graph.get_cargo_location(agent.cargo);
+    return false;
+  case 1: {
+    CacheAccessResult result = graph.cache->try_insert_cache(agent.cargo, port);
+    agent.status = result.result ? 4 : 5;
+    agent.goal = result.goal;
+    return false;
+  }
+  case 2:
+    check_cache_update(graph.cache->update_cargo_from_cache(agent.cargo, agent.goal), "get", agent.cargo);
+    agent.status = 5;
+    agent.goal = port;
+    return false;
+  case 4:
+    check_cache_update(graph.cache->update_cargo_into_cache(agent.cargo, agent.goal), "insert", agent.cargo);
+    agent.status = 5;
+    agent.goal = port;
+    return false;
+  default:
+    return true;
+  }
+}
+
+static SimResult simulate(Parser& parser, CacheType cache_type, int cache_size, const std::string& goals_file)
+{
+  parser.cache_type = cache_type;
+  parser.MT = std::mt19937(parser.random_seed);
+  Graph graph(&parser);
+  if (cache_size > 0) graph.cache->shrink(cache_size);
+  if (!goals_file.empty()) load_goals(graph, goals_file);
+
+  // Agents start at unloading ports, same grouping as Instance
+  assert(parser.num_agents % graph.group == 0);
+  uint per_group_agent = parser.num_agents / graph.group;
+  std::vector<SimAgent> agents(parser.num_agents);
+  SimResult result;
+
+  // Event queue: (time the agent reaches its goal, agent index)
+  using Event = std::pair<uint, uint>;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  for (uint j = 0; j < parser.num_agents; j++) {
+    agents[j].group = j / per_group_agent;
+    agents[j].position = graph.unloading_ports[agents[j].group];
+    assign(graph, parser, agents[j], result, 0);
+    events.push({ std::max(graph.get_distance(agents[j].position, agents[j].goal), 1), j });
+  }
+
+  uint delivered = 0;
+  while (delivered < parser.num_goals && !events.empty()) {
+    auto [time, j] = events.top();
+    events.pop();
+    SimAgent& agent = agents[j];
+    agent.position = agent.goal;
+
+    if (reach(graph, agent)) {
+      delivered++;
+      result.makespan = time;
+      result.steps += time - agent.trip_start;
+      assign(graph, parser, agent, result, time);
+    }
+    // Travel to the next goal, at least one step to pick up or drop off cargo
+    events.push({ time + std::max(graph.get_distance(agent.position, agent.goal), 1), j });
+  }
+
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  // Set up logger
+  auto console = spdlog::stderr_color_mt("console");
+  console->set_level(spdlog::level::info);
+
+  // Simulator arguments, common arguments are handled by Parser
+  argparse::ArgumentParser program("CACHE-SIM", "0.1.0");
+  program.add_argument("-sct", "--sim-cache-types").help("Comma separated cache types to evaluate. Defaults to all.").default_value(std::string("LRU,FIFO,RANDOM,LFU,ARC,TINYLFU,ADAPTIVE"));
+  program.add_argument("-scs", "--sim-cache-sizes").help("Comma separated cache blocks per group to evaluate, 0 means all blocks. Defaults to 0.").default_value(std::string("0"));
+  program.add_argument("-sgf", "--sim-goals-file").help("Path to a goals file with one 'x,y' cargo coordinate per line. Defaults to generated goals.").default_value(std::string(""));
+  try {
+    program.parse_known_args(argc, argv);
+  }
+  catch (const std::runtime_error& err) {
+    console->error("{}", err.what());
+    std::exit(1);
+  }
+
+  Parser parser(argc, argv);
+  std::string goals_file = program.get<std::string>("--sim-goals-file");
+  std::vector<int> cache_sizes;
+  for (auto& size : split(program.get<std::string>("--sim-cache-sizes"), ',')) cache_sizes.push_back(std::stoi(size));
+
+  console->info("{:>8} | {:>6} | {:>10} | {:>9} | {:>10} | {:>12}", "policy", "size", "hit rate", "makespan", "throughput", "avg steps");
+  for (auto& type_input : split(program.get<std::string>("--sim-cache-types"), ',')) {
+    CacheType cache_type;
+    if (type_input == "LRU") cache_type = CacheType::LRU;
+    else if (type_input == "FIFO") cache_type = CacheType::FIFO;
+    else if (type_input == "RANDOM") cache_type = CacheType::RANDOM;
+    else if (type_input == "LFU") cache_type = CacheType::LFU;
+    else if (type_input == "ARC") cache_type = CacheType::ARC;
+    else if (type_input == "TINYLFU") cache_type = CacheType::TINYLFU;
+    else if (type_input == "ADAPTIVE") cache_type = CacheType::ADAPTIVE;
+    else {
+      console->error("Invalid cache type: {}", type_input);
+      return 1;
+    }
+
+    for (int size : cache_sizes) {
+      SimResult result = simulate(parser, cache_type, size, goals_file);
+      double hit_rate = result.access > 0 ? static_cast<double>(result.hit) / result.access * 100.0 : 0.0;
+      double throughput = result.makespan > 0 ? static_cast<double>(parser.num_goals) / result.makespan : 0.0;
+      double avg_steps = parser.num_goals > 0 ? static_cast<double>(result.steps) / parser.num_goals : 0.0;
+      console->info("{:>8} | {:>6} | {:>9.2f}% | {:>9} | {:>10.4f} | {:>12.2f}", type_input, size, hit_rate, result.makespan, throughput, avg_steps);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,42 @@
+// Trajectory recovery
+// Converts the lifelong trajectory spill file left by an interrupted run into
+// the visual file.
+// Author: Zhenghong Yu
+
+#include <argparse/argparse.hpp>
+#include <calmapf.hpp>
+
+int main(int argc, char* argv[])
+{
+  // Set up logger
+  auto console = spdlog::stderr_color_mt("console");
+  console->set_level(spdlog::level::info);
+
+  // Recovery arguments, common arguments are handled by Parser
+  argparse::ArgumentParser program("RECOVER-TRAJECTORY", "0.1.0");
+  program.add_argument("-sf", "--spill-file").help("Path to the spill file. Defaults to the visual output file with '.spill' appended.").default_value(std::string(""));
+  try {
+    program.parse_known_args(argc, argv);
+  }
+  catch (const std::runtime_error& err) {
+    console->error("{}", err.what());
+    std::exit(1);
+  }
+
+  Parser parser(argc, argv);
+  std::string spill_file = program.get<std::string>("--spill-file");
+  if (spill_file.empty()) spill_file = parser.output_visual_file + ".spill";
+  Graph graph(&parser);
+
+  std::ofstream visual(parser.output_visual_file);
+  if (!visual.is_open()) {
+    console->error("Failed to open file: {}", parser.output_visual_file);
+    return 1;
+  }
+  if (!write_trajectory_yaml(spill_file, visual, graph.width, graph.height)) {
+    console->error("Failed to read spill file: {}", spill_file);
+    return 1;
+  }
+  console->info("Recovered {} into {}", spill_file, parser.output_visual_file);
+  return 0;
+}